@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+# Counts the mallocs of the server per keep-alive request.
+# usage: allocs.py <webserv> <mcount.so> <max mallocs per request>
+# Serves a small static file from a temp directory with logging disabled,
+# warms a single connection up and fails when the steady state average
+# is over the limit.
+import os, re, shutil, signal, socket, subprocess, sys, tempfile, time
+
+WARMUP = 50
+REQUESTS = 500
+
+def free_port():
+  s = socket.socket()
+  s.bind(('127.0.0.1', 0))
+  port = s.getsockname()[1]
+  s.close()
+  return port
+
+def setup(root, port):
+  shutil.copytree('bin/.sys/config', os.path.join(root, 'bin/.sys/config'))
+  path = os.path.join(root, 'bin/.sys/config/settings.yaml')
+  with open(path) as f:
+    yaml = f.read()
+  yaml = re.sub(r'log_level: .*', 'log_level: -1', yaml)
+  yaml = re.sub(r'workers: .*', 'workers: 1', yaml)
+  with open(path, 'w') as f:
+    f.write(yaml)
+  os.mkdir(os.path.join(root, 'www'))
+  with open(os.path.join(root, 'www/small.txt'), 'w') as f:
+    f.write('hello world\n')
+  with open(os.path.join(root, 'allocs.yaml'), 'w') as f:
+    f.write('''servers:
+  - listen: %d
+    server_names: localhost
+    routes:
+      - uri: /
+        settings:
+          methods: [GET, HEAD]
+        modules:
+          - type: static
+            settings:
+              root: %s
+''' % (port, os.path.join(root, 'www')))
+
+def connect(port, server):
+  for _ in range(50):
+    if server.poll() is not None:
+      sys.exit('webserv exited with %d' % server.returncode)
+    try:
+      return socket.create_connection(('127.0.0.1', port))
+    except OSError:
+      time.sleep(0.1)
+  sys.exit('webserv is not listening on port %d' % port)
+
+def request(s, req):
+  s.sendall(req)
+  data = b''
+  while True:
+    chunk = s.recv(65536)
+    if not chunk:
+      sys.exit('connection closed: %r' % data[:200])
+    data += chunk
+    end = data.find(b'\r\n\r\n')
+    if end < 0:
+      continue
+    if not data.startswith(b'HTTP/1.1 200'):
+      sys.exit('unexpected response: %r' % data[:200])
+    length = 0
+    for line in data[:end].split(b'\r\n')[1:]:
+      name, _, value = line.partition(b':')
+      if name.strip().lower() == b'content-length':
+        length = int(value)
+    if len(data) >= end + 4 + length:
+      return
+
+def count(server, out):
+  if os.path.exists(out):
+    os.remove(out)
+  server.send_signal(signal.SIGUSR2)
+  for _ in range(50):
+    if os.path.exists(out):
+      with open(out) as f:
+        value = f.read()
+      if value.endswith('\n'):
+        return int(value)
+    time.sleep(0.02)
+  sys.exit('no malloc count written to %s' % out)
+
+def main():
+  if len(sys.argv) != 4:
+    sys.exit('usage: %s <webserv> <mcount.so> <max mallocs per request>' % sys.argv[0])
+  binary = os.path.abspath(sys.argv[1])
+  preload = os.path.abspath(sys.argv[2])
+  limit = float(sys.argv[3])
+  root = tempfile.mkdtemp(prefix='webserv_allocs')
+  port = free_port()
+  setup(root, port)
+  out = os.path.join(root, 'mcount.out')
+  env = dict(os.environ, LD_PRELOAD=preload, MCOUNT_OUT=out)
+  server = subprocess.Popen([binary, 'allocs.yaml'], cwd=root, env=env,
+    stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+  try:
+    s = connect(port, server)
+    req = b'GET /small.txt?a=1&b=2 HTTP/1.1\r\nHost: localhost\r\nUser-Agent: allocs/1.0\r\nAccept: */*\r\n\r\n'
+    for _ in range(WARMUP):
+      request(s, req)
+    before = count(server, out)
+    for _ in range(REQUESTS):
+      request(s, req)
+    after = count(server, out)
+    s.close()
+  finally:
+    server.kill()
+    server.wait()
+    shutil.rmtree(root)
+  perRequest = (after - before) / float(REQUESTS)
+  print('mallocs per keep-alive request: %.1f (max %g)' % (perRequest, limit))
+  if perRequest > limit:
+    sys.exit(1)
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,160 @@
+"""
+Minimal FastCGI responder running python CGI scripts in process,
+used as the worker of an interpreter with mode: fastcgi (php-cgi plays the same role for php).
+The server hands it a listening socket as stdin, connects once & keeps the connection (FCGI_KEEP_CONN),
+so the interpreter & the modules the scripts import are loaded once instead of on every request.
+Requests are run one at a time, the script comes from SCRIPT_FILENAME.
+"""
+import io
+import os
+import runpy
+import socket
+import struct
+import sys
+import traceback
+
+VERSION = 1
+BEGIN_REQUEST, ABORT_REQUEST, END_REQUEST, PARAMS, STDIN, STDOUT, STDERR = range(1, 8)
+KEEP_CONN = 1
+HEADER = struct.Struct("!BBHHBx")
+MAX_CONTENT = 65535
+
+BASE_ENV = dict(os.environ)
+BASE_CWD = os.getcwd()
+
+
+def read_exact(conn, size):
+    data = b""
+    while len(data) < size:
+        chunk = conn.recv(size - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return data
+
+
+def read_record(conn):
+    header = read_exact(conn, HEADER.size)
+    if header is None:
+        return None
+    version, kind, request_id, length, padding = HEADER.unpack(header)
+    if version != VERSION:
+        return None
+    content = read_exact(conn, length + padding)
+    if content is None:
+        return None
+    return kind, request_id, content[:length]
+
+
+def write_record(out, kind, request_id, content=b""):
+    padding = -len(content) % 8
+    out += HEADER.pack(VERSION, kind, request_id, len(content), padding)
+    out += content + b"\0" * padding
+
+
+def write_stream(out, kind, request_id, content):
+    for offset in range(0, len(content), MAX_CONTENT):
+        write_record(out, kind, request_id, content[offset:offset + MAX_CONTENT])
+    write_record(out, kind, request_id)
+
+
+def read_length(data, offset):
+    if data[offset] < 128:
+        return data[offset], offset + 1
+    return struct.unpack("!I", data[offset:offset + 4])[0] & 0x7fffffff, offset + 4
+
+
+def parse_params(data):
+    params = {}
+    offset = 0
+    while offset < len(data):
+        name_size, offset = read_length(data, offset)
+        value_size, offset = read_length(data, offset)
+        name = data[offset:offset + name_size].decode("latin-1")
+        offset += name_size
+        params[name] = data[offset:offset + value_size].decode("latin-1")
+        offset += value_size
+    return params
+
+
+def run_script(params, body):
+    """Runs the script like a CGI process would, returns (stdout, stderr, status)."""
+    script = params.get("SCRIPT_FILENAME", "")
+    stdout = io.BytesIO()
+    stderr = io.StringIO()
+    status = 0
+    saved = (sys.stdin, sys.stdout, sys.stderr, sys.argv)
+    os.environ.clear()
+    os.environ.update(BASE_ENV)
+    os.environ.update(params)
+    sys.stdin = io.TextIOWrapper(io.BytesIO(body), encoding="latin-1")
+    # detached once done, closing the wrapper would close stdout with it
+    wrapper = io.TextIOWrapper(stdout, encoding="utf-8", write_through=True)
+    sys.stdout = wrapper
+    sys.stderr = stderr
+    sys.argv = [script]
+    try:
+        os.chdir(os.path.dirname(script) or BASE_CWD)
+        runpy.run_path(script, run_name="__main__")
+    except SystemExit as e:
+        status = e.code if isinstance(e.code, int) else 1
+    except BaseException:
+        traceback.print_exc()
+        stdout.seek(0)
+        stdout.truncate()
+        wrapper.write("Status: 500 Internal Server Error\n\n")
+        status = 1
+    finally:
+        wrapper.flush()
+        wrapper.detach()
+        sys.stdin, sys.stdout, sys.stderr, sys.argv = saved
+        os.chdir(BASE_CWD)
+    return stdout.getvalue(), stderr.getvalue().encode("utf-8"), status
+
+
+def serve(conn):
+    """Serves requests over conn until the server closes it, or asks for it with no KEEP_CONN."""
+    request_id, flags, params, body = 0, 0, b"", b""
+    while True:
+        record = read_record(conn)
+        if record is None:
+            return
+        kind, rid, content = record
+        if kind == BEGIN_REQUEST:
+            request_id, flags, params, body = rid, content[2], b"", b""
+            continue
+        if rid != request_id:
+            continue
+        out = bytearray()
+        if kind == PARAMS:
+            params += content
+            continue
+        if kind == ABORT_REQUEST:
+            write_record(out, END_REQUEST, rid, struct.pack("!IB3x", 1, 0))
+        elif kind == STDIN and content:
+            body += content
+            continue
+        elif kind == STDIN:
+            stdout, stderr, status = run_script(parse_params(params), body)
+            write_stream(out, STDOUT, rid, stdout)
+            if stderr:
+                write_stream(out, STDERR, rid, stderr)
+            write_record(out, END_REQUEST, rid, struct.pack("!IB3x", status & 0xffffffff, 0))
+        else:
+            continue
+        conn.sendall(out)
+        request_id = 0
+        if not flags & KEEP_CONN:
+            return
+
+
+def main():
+    # the server connects once & keeps the connection, it's done with the worker once it closes it
+    listener = socket.socket(fileno=0)
+    conn, _ = listener.accept()
+    with conn:
+        serve(conn)
+
+
+if __name__ == "__main__":
+    main()
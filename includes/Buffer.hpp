@@ -1,6 +1,9 @@
 /**
  * Buffer.hpp
  * Generic Buffer class using std::vector.
+ * Consuming from the front only moves a read cursor,
+ * the consumed prefix is dropped once it outweighs the live data (amortized O(1)).
+ * The live data always stays contiguous, so data() can be handed to send/memchr as is.
 */
 #pragma once
 
@@ -9,27 +12,46 @@
 #include <vector>
 #include <stdint.h>
 #include <cstring>
+#include <algorithm>
 
 template <typename T>
 class Buffer {
 private:
-  std::vector<T> buffer;
+  // mutable so const views of the raw vector can drop the consumed prefix first
+  mutable std::vector<T> buffer;
+  // read cursor, everything before it was already consumed
+  mutable uint64_t offset;
+
+  // don't bother moving memory for small consumed prefixes
+  static const uint64_t compactThreshold = 4096;
+
+  void compact() const {
+    if (this->offset == 0) return;
+    this->buffer.erase(this->buffer.begin(), this->buffer.begin() + this->offset);
+    this->offset = 0;
+  }
 public:
-  Buffer() {}
-  Buffer(uint64_t size) : buffer(size) {}
-  Buffer(const Buffer<T>& other) : buffer(other.buffer) {}
+  Buffer() : offset(0) {}
+  Buffer(uint64_t size) : buffer(size), offset(0) {}
+  Buffer(const Buffer<T>& other) : buffer(other.buffer.begin() + other.offset, other.buffer.end()), offset(0) {}
   Buffer<T>& operator=(const Buffer<T>& other) {
-    this->buffer = other.buffer;
+    if (this == &other) return *this;
+    this->buffer.assign(other.buffer.begin() + other.offset, other.buffer.end());
+    this->offset = 0;
     return *this;
   }
   ~Buffer() {}
-  inline uint64_t size() const { return this->buffer.size(); }
-  inline bool empty() const { return this->buffer.empty(); }
-  inline T* data() { return this->buffer.data(); }
-  inline const T* data() const { return this->buffer.data(); }
-  inline void resize(uint64_t size) { this->buffer.resize(size); }
-  inline void reserve(uint64_t size) { this->buffer.reserve(size); }
-  inline void clear() { this->buffer.clear(); }
+  inline uint64_t size() const { return this->buffer.size() - this->offset; }
+  inline bool empty() const { return this->size() == 0; }
+  inline T* data() { return this->buffer.data() + this->offset; }
+  inline const T* data() const { return this->buffer.data() + this->offset; }
+  inline void resize(uint64_t size) { this->buffer.resize(this->offset + size); }
+  inline void reserve(uint64_t size) { this->buffer.reserve(this->offset + size); }
+  inline void clear() { this->buffer.clear(); this->offset = 0; }
+  inline void swap(Buffer<T>& other) {
+    this->buffer.swap(other.buffer);
+    std::swap(this->offset, other.offset);
+  }
   inline void put(const T& value) { this->buffer.push_back(value); }
   template <typename K>
   void put(const K& value, uint64_t amount) {
@@ -40,18 +62,18 @@ public:
   inline void put(const std::vector<T>& value) { this->put(value, value.size()); }
   inline void put(const Buffer<T>& value) { this->put(value, value.size()); }
   inline void put(const std::string& value) { this->put(value, value.size()); }
-  inline T& operator[](uint64_t index) { return this->buffer[index]; }
-  inline const T& operator[](uint64_t index) const { return this->buffer[index]; }
-  inline T& at(uint64_t index) { return this->buffer.at(index); }
-  inline const T& at(uint64_t index) const { return this->buffer.at(index); }
-  inline T& peek() { return this->buffer.front(); }
-  inline const T& peek() const { return this->buffer.front(); }
+  inline T& operator[](uint64_t index) { return this->buffer[this->offset + index]; }
+  inline const T& operator[](uint64_t index) const { return this->buffer[this->offset + index]; }
+  inline T& at(uint64_t index) { return this->buffer.at(this->offset + index); }
+  inline const T& at(uint64_t index) const { return this->buffer.at(this->offset + index); }
+  inline T& peek() { return this->buffer[this->offset]; }
+  inline const T& peek() const { return this->buffer[this->offset]; }
 
   template <typename U>
   U peek() const {
     std::stringstream ss;
     for (uint64_t i = 0; i < sizeof(U); ++i)
-      ss << this->buffer[i];
+      ss << (*this)[i];
     U value;
     ss >> value;
     return value;
@@ -59,13 +81,13 @@ public:
   template<>
   int peek<int>() const {
     if (this->empty()) return -1;
-    return static_cast<int>(this->buffer[0]);
+    return static_cast<int>(this->peek());
   }
 
   template<>
   std::string peek<std::string>() const {
     std::stringstream ss;
-    for (uint64_t i = 0; i < this->buffer.size(); ++i)
+    for (uint64_t i = this->offset; i < this->buffer.size(); ++i)
       ss << this->buffer[i];
     return ss.str();
   }
@@ -73,31 +95,41 @@ public:
   template <typename U>
   U get() {
     const U value = this->peek<U>();
-    this->buffer.erase(this->buffer.begin());
+    this->ignore();
     return value;
   }
   template <>
   T get() {
-    const T& value = this->peek();
-    this->buffer.erase(this->buffer.begin());
+    const T value = this->peek();
+    this->ignore();
     return value;
   }
   template <>
   int get() {
     if (this->empty()) return -1;
     const int value = this->peek();
-    this->buffer.erase(this->buffer.begin());
+    this->ignore();
     return value;
   }
+  /*
+   * Consumes bytes from the front.
+   * Only moves the read cursor, the consumed prefix is dropped
+   * once the buffer is drained or the prefix outweighs the live data.
+   */
   inline void ignore(uint64_t bytes = 1) {
     if (bytes == 0) return;
-    this->buffer.erase(this->buffer.begin(), this->buffer.begin() + std::min(bytes, this->size()));
+    this->offset += std::min(bytes, this->size());
+    if (this->offset == this->buffer.size())
+      this->clear();
+    else if (this->offset >= compactThreshold && this->offset >= this->size())
+      this->compact();
   }
   void take(Buffer<T>& value, uint64_t bytes = 1) {
     if (bytes == 0) return;
+    bytes = std::min(bytes, this->size());
     value.clear();
     value.resize(bytes);
-    std::memmove(value.data(), value.data() + bytes, value.size() - bytes);
+    std::memcpy(value.data(), this->data(), bytes * sizeof(T));
     this->ignore(bytes);
   }
 
@@ -118,11 +150,8 @@ public:
 
   template<>
   std::string take() {
-    std::string value;
-    value.resize(this->size() + 1);
-    for (uint64_t i = 0; i < this->size(); ++i)
-      value[i] = this->get<char>();
-    value[this->size()] = '\0';
+    const std::string value = this->peek<std::string>();
+    this->clear();
     return value;
   }
 
@@ -131,12 +160,13 @@ public:
   }
 
   inline Buffer<T>& operator<<(const T& value) { this->put(value); return *this; }
-  inline operator std::vector<T>& () { return this->buffer; }
-  inline operator const std::vector<T>& () const { return this->buffer; }
-  inline operator std::vector<T>* () { return &this->buffer; }
-  inline operator const std::vector<T>* () const { return &this->buffer; }
-  inline operator void* () { return this->buffer.data(); }
-  inline operator const void* () const { return this->buffer.data(); }
+  // raw vector views, the consumed prefix is dropped first
+  inline operator std::vector<T>& () { this->compact(); return this->buffer; }
+  inline operator const std::vector<T>& () const { this->compact(); return this->buffer; }
+  inline operator std::vector<T>* () { this->compact(); return &this->buffer; }
+  inline operator const std::vector<T>* () const { this->compact(); return &this->buffer; }
+  inline operator void* () { return this->data(); }
+  inline operator const void* () const { return this->data(); }
   inline operator bool() const { return this->size() > 0; }
   inline bool operator!() const { return this->size() == 0; }
 };
\ No newline at end of file
@@ -3,6 +3,8 @@
  * Settings class using Instance that loads & interprets a YAML settings file.
  * This is useful for storing settings that are used everywhere, like HTTP status codes.
  * Has some helper methods for mime types & status codes, everything else goes through get<T>.
+ * Settings read while serving requests are resolved once, when the file is loaded, into a Snapshot:
+ * hot paths read its plain fields, & a missing or malformed key fails isValid on boot instead of the first request.
 */
 #pragma once
 
@@ -11,10 +13,55 @@
 #include <utils/misc.hpp>
 #include <shared.hpp>
 
+#include <map>
+#include <stdint.h>
+
 class Settings {
   static const char* path;
 public:
+  struct Snapshot {
+    // yaml.*
+    bool runTests;
+    // socket.*
+    int workers;
+    int epollBatch;
+    int acceptBudget;
+    int maxConnections;
+    int keepAliveTimeout;
+    uint32_t maxRequestsPerConnection;
+    // deprecated & optional
+    bool hasPollTimeout;
+    int pollTimeout;
+    uint64_t readBufferSize;
+    uint64_t writeBufferSize;
+    // http.*
+    uint32_t maxBodySize;
+    size_t maxUriSize;
+    uint64_t requestBodyMaxMemory;
+    std::string requestBodyTempDir;
+    std::map<int, std::string> statusCodes;
+    std::string defaultIndex;
+    std::string directoryBuilderTemplate;
+    uint64_t fileChunks;
+    uint64_t fileChunkSize;
+    uint64_t fileCacheMaxEntries;
+    uint64_t fileCacheTtl;
+    uint64_t responseCacheMaxFileSize;
+    uint64_t responseCacheMaxMemory;
+    int cgiTimeout;
+    int fastCGIMinWorkers;
+    int fastCGIMaxWorkers;
+    int fastCGIIdleTimeout;
+    // misc.*, errors only until resolved
+    int logLevel;
+    std::string name;
+    std::string defaultConfigFile;
+
+    Snapshot();
+  };
+
   bool isValid() const;
+  inline const Snapshot& getSnapshot() const { return this->snapshot; }
 
   template <typename T>
   T get(const std::string& path) const {
@@ -34,13 +81,25 @@ public:
       else
         node = &node->get(key);
     }
-    return node->as<T>();
+    try {
+      return node->as<T>();
+    }
+    catch (const std::exception& e) {
+      throw std::runtime_error(path + ": " + e.what());
+    }
   }
-  const std::string httpStatusCode(int code) const;
+  // empty if code is unknown
+  const std::string& httpStatusCode(int code) const;
   const std::string& httpMimeType(const std::string& ext) const;
 private:
   Settings();
   const YAML::Node config;
+  Snapshot snapshot;
+  bool resolved;
+  // why resolve failed, reported by isValid
+  std::string resolveError;
+
+  void resolve();
 
   friend class Instance;
 };
\ No newline at end of file
@@ -0,0 +1,29 @@
+/**
+ * ChunkedFile.hpp
+ * Write queue producer that streams a file with Transfer-Encoding: chunked.
+ * A chunk is only read from disk when the connection's write queue runs low,
+ * so big files are sent with bounded memory & without blocking the event loop.
+*/
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <stdint.h>
+#include <socket/WriteQueue.hpp>
+
+namespace HTTP {
+  class ChunkedFile : public Socket::WriteQueue::Producer {
+  public:
+    ChunkedFile(const std::string& path, uint64_t chunkSize);
+    ~ChunkedFile();
+
+    inline bool isOpen() const { return this->file.is_open() && this->file.good(); }
+    bool produce(Socket::WriteQueue& queue);
+  private:
+    ChunkedFile(const ChunkedFile& other);
+    ChunkedFile& operator=(const ChunkedFile& other);
+
+    std::ifstream file;
+    uint64_t chunkSize;
+  };
+}
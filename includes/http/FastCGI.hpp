@@ -0,0 +1,176 @@
+/**
+ * FastCGI.hpp
+ * Pools of persistent FastCGI workers, used by the CGI interpreters running with mode: fastcgi.
+ * Each worker is spawned once, with a listening unix socket (abstract namespace) as its stdin as the protocol expects,
+ * & the server keeps a single connection to it (FCGI_KEEP_CONN), so a warm request never creates a process.
+ * A worker runs one request at a time (php-cgi & most apps don't multiplex a connection),
+ * concurrent requests are spread over up to max workers & the rest wait in the pool's queue.
+ * Workers past min are retired once idle for http.cgi.fastcgi.idle_timeout, dead ones are replaced on demand.
+ * Pools are owned by the HTTP::WebSocket, which sends the responses of finished jobs (see WebSocket::onFastCGIExit).
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <socket/FileManager.hpp>
+#include <socket/TimerWheel.hpp>
+#include <socket/Process.hpp>
+#include "PendingResponse.hpp"
+
+namespace HTTP {
+  class WebSocket;
+  namespace FastCGI {
+    struct RecordTypes {
+      enum Type {
+        BeginRequest = 1,
+        AbortRequest = 2,
+        EndRequest = 3,
+        Params = 4,
+        Stdin = 5,
+        Stdout = 6,
+        Stderr = 7
+      };
+    };
+
+    typedef Socket::Process::ExitCodes ExitCodes;
+
+    class Pool;
+    class Worker;
+
+    // a request handed to a pool, along with the response it builds
+    class Job {
+    public:
+      // params are the encoded request meta-variables (see PutParam), taken over
+      // bodyFd is the spilled body of the request (owned) or -1
+      Job(Pool& pool, Response& res, ByteStream& params, int bodyFd);
+      ~Job();
+
+      inline Pool& getPool() const { return this->pool; }
+      inline PendingResponse& getPending() const { return *this->pending; }
+      inline Socket::Connection& getClient() const {
+        return const_cast<Socket::Connection&>(this->pending->request.getClient());
+      }
+    private:
+      friend class Worker;
+      friend class Pool;
+
+      Pool& pool;
+      PendingResponse* pending;
+      // the records are built once a worker picks it up & its request id is known
+      ByteStream params;
+      ByteStream body;
+      int bodyFd;
+      Worker* worker;
+
+      Job(const Job& other);
+      Job& operator=(const Job& other);
+    };
+
+    class Worker {
+    public:
+      struct States {
+        enum State {
+          Idle,
+          Busy,
+          // its job was aborted, waiting for the end of the request before reuse
+          Draining
+        };
+      };
+
+      Worker(Pool& pool, pid_t pid, int fd);
+      ~Worker();
+
+      inline pid_t getId() const { return this->pid; }
+      inline int getFd() const { return this->fd; }
+      inline States::State getState() const { return this->state; }
+      inline Job* getJob() const { return this->job; }
+      inline Socket::Timer& getTimer() { return this->timer; }
+
+      void start(Job* job);
+      // drops its job, the worker is asked to stop it & reused once it did
+      void abort();
+      void onEvent(const Socket::File& file);
+      void onTimeout();
+    private:
+      friend class Pool;
+
+      Pool& pool;
+      pid_t pid;
+      int fd;
+      States::State state;
+      Job* job;
+      uint16_t requestId;
+      ByteStream readBuffer;
+      ByteStream writeBuffer;
+      bool writing;
+      Socket::Timer timer;
+
+      void read();
+      // write errors are picked up as an event on the socket
+      // false if the body couldn't be read, the worker is gone with its job
+      bool write();
+      // feeds the next chunk of a spilled body, false once it was all sent or if reading it failed
+      bool feedBody(bool& failed);
+      void setWriting(bool state);
+
+      Worker(const Worker& other);
+      Worker& operator=(const Worker& other);
+    };
+
+    class Pool {
+    public:
+      Pool(WebSocket& loop, const std::string& path, const std::vector<std::string>& args, int minWorkers, int maxWorkers);
+      ~Pool();
+
+      // spawns the min workers
+      void start();
+      // false if there are no workers & none could be spawned, the job is left to the caller
+      bool submit(Job* job);
+      // its client went away, the job is done with right away
+      void cancel(Job* job);
+
+      inline WebSocket& getLoop() const { return this->loop; }
+      inline const std::string& getPath() const { return this->path; }
+    private:
+      friend class Worker;
+
+      WebSocket& loop;
+      std::string path;
+      std::vector<std::string> args;
+      size_t minWorkers;
+      size_t maxWorkers;
+      std::vector<Worker*> workers;
+      std::deque<Job*> queue;
+      // the process that spawned the workers, forked children must not touch them
+      pid_t owner;
+      uint64_t spawned;
+
+      // NULL if it failed
+      Worker* spawn();
+      // hands queued jobs to idle workers, spawning new ones up to max,
+      // then schedules the retirement of the idle ones past min
+      void dispatch();
+      // its response is sent & it's deleted
+      void onJobDone(Job* job, ExitCodes::Code code);
+      // its request ended
+      void onWorkerDone(Worker& worker);
+      // it died, timed out or broke the protocol, its job (if any) ends with code
+      void onWorkerExit(Worker& worker, ExitCodes::Code code);
+      // kills & reaps it, the worker is deleted
+      void retire(Worker& worker);
+
+      Pool(const Pool& other);
+      Pool& operator=(const Pool& other);
+    };
+
+    // appends a record, padded to 8 bytes, content must fit in one (65535 bytes)
+    void PutRecord(ByteStream& out, RecordTypes::Type type, uint16_t requestId, const uint8_t* data, size_t size);
+    // splits the stream into as many records as needed
+    void PutStream(ByteStream& out, RecordTypes::Type type, uint16_t requestId, const uint8_t* data, size_t size);
+    void PutParam(ByteStream& out, const std::string& name, const std::string& value);
+  }
+}
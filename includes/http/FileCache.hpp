@@ -0,0 +1,59 @@
+/**
+ * FileCache.hpp
+ * Singleton LRU cache of the files served by Routing::Static.
+ * Keyed by resolved path, it holds the open fd (shared with the write queues sending it),
+ * the stat data, the ETag, Last-Modified & MIME type strings.
+ * Entries are trusted for http.static.file_cache.ttl ms, then checked again with a single stat.
+ * A hot file is served without any syscall besides the send itself.
+*/
+#pragma once
+
+#include <string>
+#include <map>
+#include <list>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <socket/WriteQueue.hpp>
+
+namespace HTTP {
+  class FileCache {
+  public:
+    struct Entry {
+      std::string path;
+      Socket::WriteQueue::SharedFd* file;
+      struct stat st;
+      std::string etag;
+      std::string lastModified;
+      std::string mimeType;
+      uint64_t validatedAt;
+    };
+
+    FileCache();
+    ~FileCache();
+
+    /*
+     * Returns the entry of the regular file at path, NULL if it can't be served.
+     * The pointer stays valid until the next call to get or invalidate.
+     */
+    const Entry* get(const std::string& path);
+    void invalidate(const std::string& path);
+    void clear();
+
+    inline size_t size() const { return this->entries.size(); }
+  private:
+    FileCache(const FileCache& other);
+    FileCache& operator=(const FileCache& other);
+
+    typedef std::list<Entry*> List;
+
+    // most recently used first
+    List lru;
+    std::map<std::string, List::iterator> entries;
+    size_t maxEntries;
+    uint64_t ttl;
+
+    Entry* load(const std::string& path);
+    bool isStale(const Entry& entry, const struct stat& st) const;
+    void evict(List::iterator it);
+  };
+}
@@ -1,9 +1,14 @@
 /**
  * Headers.hpp
  * HTTP Headers class.
- * Stores a key-value pair of HTTP headers.
+ * Stores a key-value pair of HTTP headers, in insertion order.
  * All keys are formatted to be trimmed & lowercased internally.
  * All values are formatted to be trimmed.
+ * Entries live in a Utils::Arena: either the one given on construction
+ * (i.e. the connection's, reset once the request is done) or its own.
+ * Copies always keep their own memory, so they can outlive the arena they were copied from.
+ * Entries are a flat array, each with the hash of its name, well-known ones (Headers::Names)
+ * are also indexed, so looking them up is O(1) & never allocates.
 */
 #pragma once
 
@@ -14,48 +19,116 @@
 #include <sstream>
 #include <vector>
 #include <algorithm>
+#include <cstring>
+#include <stdint.h>
 
 #include <sstream>
 #include <iomanip>
 
 #include <utils/misc.hpp>
+#include <utils/Arena.hpp>
 #include <http/utils.hpp>
 
 namespace HTTP {
   class Headers {
   public:
+    // looked up through an index instead of scanning the entries
+    struct Names {
+      enum Name {
+        Host,
+        Connection,
+        KeepAlive,
+        ContentLength,
+        ContentType,
+        TransferEncoding,
+        Expect,
+        IfNoneMatch,
+        IfModifiedSince,
+        Date,
+        Server,
+        Location,
+        LastModified,
+        ETag,
+        // any other, also the amount of well-known ones
+        Unknown
+      };
+      // case insensitive
+      static Name FromString(const char* str, size_t size);
+      // lowercased
+      static const char* ToString(Name name);
+    };
+
+    // both trimmed & NUL terminated, the name lowercased
+    struct Entry {
+      const char* name;
+      size_t nameSize;
+      const char* value;
+      size_t valueSize;
+      // of the name, compared before its bytes
+      uint32_t hash;
+      Names::Name id;
+
+      inline bool is(const char* str) const {
+        return std::strlen(str) == this->valueSize && std::memcmp(str, this->value, this->valueSize) == 0;
+      }
+    };
+
     static std::string FormatKey(const std::string& key);
     static std::string FormatValue(const std::string& value);
+    // FNV-1a of the lowercased str
+    static uint32_t Hash(const char* str, size_t size);
+    // digits only, false if there are none, anything else, or it overflows
+    static bool ParseNumber(const char* str, size_t size, uint64_t& value);
 
     Headers();
+    // entries are allocated from arena, don't use them past its next reset
+    explicit Headers(Utils::Arena& arena);
     ~Headers();
     Headers(const Headers& other);
     Headers& operator=(const Headers& other);
+    void swap(Headers& other);
     void clear();
     bool append(const std::string& key, const std::string& value);
+    // straight from a buffer, no formatting copies
+    bool append(const char* key, size_t keySize, const char* value, size_t valueSize);
+    // well-known name, nothing to lowercase or hash
+    bool append(Names::Name name, const char* value, size_t valueSize);
+    inline bool append(Names::Name name, const std::string& value) {
+      return this->append(name, value.data(), value.size());
+    }
     void remove(const std::string& key);
+    void remove(Names::Name name);
     bool has(const std::string& key) const;
+    bool has(const char* key) const;
+    bool has(Names::Name name) const;
+    // NULL if there is none
+    const Entry* find(const std::string& key) const;
+    const Entry* find(Names::Name name) const;
+    // false if there is none or it isn't a number (see ParseNumber)
+    bool getNumber(Names::Name name, uint64_t& value) const;
 
     template <typename T>
     T get(const std::string& key) const {
-      std::string formatted = this->FormatKey(key);
+      const Entry* entry = this->lookup(key.data(), key.size());
       T value;
-      if (!this->has(formatted))
+      if (!entry)
         throw std::runtime_error("Key " + key + " not found");
-      std::stringstream ss(this->headers.at(formatted));
+      std::stringstream ss(std::string(entry->value, entry->valueSize));
       ss >> value;
       return value;
     }
 
     template <>
     std::string get(const std::string& key) const {
-      std::string formatted = this->FormatKey(key);
-      if (!this->has(formatted))
+      const Entry* entry = this->lookup(key.data(), key.size());
+      if (!entry)
         throw std::runtime_error("Key " + key + " not found");
-      return this->headers.at(formatted);
+      return std::string(entry->value, entry->valueSize);
     }
 
-    const std::map<std::string, std::string>& getAll() const;
+    inline size_t size() const { return this->count; }
+    inline const Entry& operator[](size_t i) const { return this->entries[i]; }
+    inline Utils::Arena& getArena() const { return *this->arena; }
 
     template <typename T>
     void set(const std::string& key, const T& value) {
@@ -73,19 +146,34 @@ namespace HTTP {
 
     template <>
     void set<std::string>(const std::string& key, const std::string& value) {
-      std::string formatted = this->FormatKey(key);
-      std::string formattedValue = this->FormatValue(value);
-      if (this->headers.count(formatted) == 0)
-        this->keys.push_back(formatted);
-      this->headers[formatted] = formattedValue;
+      this->set(key, value.data(), value.size());
     }
 
+    inline void set(const std::string& key, const char* value) {
+      this->set(key, value, std::strlen(value));
+    }
+    void set(const std::string& key, const char* value, size_t valueSize);
+
     operator std::string() const;
     std::string toString() const;
     friend std::ostream& operator<<(std::ostream& os, const Headers& headers);
   private:
-    std::map<std::string, std::string> headers;
-    std::vector<std::string> keys;
+    Utils::Arena memory;
+    // &memory, or the arena given on construction
+    Utils::Arena* arena;
+    Entry* entries;
+    size_t count;
+    size_t capacity;
+    // position + 1 of each well-known header, 0 if there is none
+    uint32_t index[Names::Unknown];
+
+    Entry* lookup(const char* key, size_t keySize) const;
+    Entry* lookup(Names::Name name) const;
+    Entry& push();
+    Entry& add(const char* key, size_t keySize);
+    Entry& add(Names::Name name);
+    void assign(Entry& entry, const char* value, size_t valueSize);
+    void removeAt(size_t i);
   };
 
-}
\ No newline at end of file
+}
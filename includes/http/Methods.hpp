@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <stdint.h>
 
 // SOURCE: https://www.rfc-editor.org/rfc/rfc9110.html#name-methods
 namespace HTTP {
@@ -14,6 +15,9 @@ namespace HTTP {
       PUT,
     };
     Method FromString(const std::string& str);
+    Method FromString(const char* str, size_t size);
     std::string ToString(Method method);
+    // of method in a set of allowed methods
+    inline uint32_t ToBit(Method method) { return 1u << method; }
   };
 }
\ No newline at end of file
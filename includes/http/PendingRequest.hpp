@@ -2,12 +2,15 @@
  * PendingRequest.hpp
  * Extends HTTP::Request to add a state machine to parse the request.
  * It adds a bunch of setters.
- * It parses an socket packet byte by byte*.
+ * The head (request line & headers) is parsed in place by its RequestParser*.
  * It also has a bunch of helpers to build a request.
- * It is used by the HTTP::WebSocket class.
+ * It is used by the HTTP::WebSocket class, one per connection, reset between its requests**.
  * If anything goes wrong while parsing, it will send a HTTP::Response and close the connection.
- * *: It parses byte by byte until it ends the headers.
- *    Then it parses the body in chunks (min between packet size & size left) depending on the Content-Length header or ChunkSize.
+ * *: The parser resumes across packets, the head is only copied out once it is complete.
+ *    Then the body is consumed in chunks (min between packet size & size left) depending on the Content-Length header or chunk sizes,
+ *    each one is appended to its HTTP::RequestBody as it arrives (spilling to a temp file past a threshold).
+ * **: Headers live in the connection's arena, reset along with it. Strings & the parser keep their capacity,
+ *     so a keep-alive connection stops allocating once warmed up.
 */
 #pragma once
 
@@ -18,7 +21,7 @@
 #include "Methods.hpp"
 #include "Headers.hpp"
 #include "Request.hpp"
-#include "HTTPStream.hpp"
+#include "RequestParser.hpp"
 
 namespace HTTP {
   class WebSocket;
@@ -32,6 +35,9 @@ namespace HTTP {
         Body,
         BodyChunkSize,
         BodyChunkData,
+        // CRLF after the chunk data
+        BodyChunkEnd,
+        BodyTrailers,
         Done
       };
       static std::string ToString(State state);
@@ -57,11 +63,14 @@ namespace HTTP {
     States::State getState() const;
     void setState(const States::State state);
     void next();
+    inline RequestParser& getParser() { return this->parser; }
     Headers& getHeaders();
     using Request::getHeaders;
 
     void setMethod(const Methods::Method method);
+    // the raw request target, its query is parsed right away
     void setPath(const std::string& path);
+    void setPath(const char* path, size_t size);
     using Request::getProtocol;
     Protocol getProtocol() const;
     void setProtocol(const std::string& protocol);
@@ -69,53 +78,31 @@ namespace HTTP {
     void setProtocolType(const std::string& protocolType);
     void setVersionMajor(const int versionMajor);
     void setVersionMinor(const int versionMinor);
-    void setBody(const std::string& body);
-    void setBody(const ByteStream& body);
-    void addToBody(const std::string& body);
-    void addToBody(const ByteStream& body, size_t size = -1);
+    RequestBody& getBody();
+    using Request::getBody;
+    void addToBody(const ByteStream& body, size_t size);
     void setHeaders(const Headers& headers);
+    // ready for the next request of the connection, drops everything in its arena
+    void reset();
 
     friend std::ostream& operator<<(std::ostream& os, const PendingRequest& request);
 
     // quick helpers for request builder
     inline size_t getContentLength() const {
-      return this->getHeaders().get<size_t>("Content-Length");
+      uint64_t length = 0;
+      this->getHeaders().getNumber(Headers::Names::ContentLength, length);
+      return length;
     }
-
-    inline void handlePacket(HTTPStream& packet) {
-      this->cPacket = &packet;
-    }
-    inline bool isParsingBody() const {
-      return this->state == States::Body || this->state == States::BodyChunkData;
+    inline bool isParsingHead() const {
+      return this->state == States::Uri || this->state == States::Headers;
     }
-    inline void reset(bool clearChunkData = false) {
-      this->storage.clear();
-      if (clearChunkData) this->chunkData.clear();
-    }
-
-    template <typename T>
-    inline T takeFromStorage() {
-      std::stringstream ss(this->storage);
-      T tmp;
-      ss >> tmp;
-      this->storage.clear();
-      return tmp;
-    }
-    template <>
-    inline std::string takeFromStorage<std::string>() {
-      std::string tmp = this->storage;
-      this->storage.clear();
-      return tmp;
-    }
-
-    bool lastCheck();
   private:
     States::State state;
-    std::string storage;
-    std::string buildingHeaderKey;
+    RequestParser parser;
+    // bytes left in the current chunk
     size_t chunkSize;
-    ByteStream chunkData;
-    HTTPStream* cPacket;
+    // of the route handling it, resolved once the headers are parsed (0 for unlimited)
+    size_t maxBodySize;
 
     PendingRequest();
     friend class WebSocket;
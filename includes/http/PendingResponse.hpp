@@ -1,6 +1,7 @@
 /**
  * PendingResponse.hpp
  * Small workaround to store a Request & a Response together for CGI scripts.
+ * Built in place (kept by pointer), the response refers to the request stored next to it.
 */
 #pragma once
 
@@ -11,5 +12,11 @@ namespace HTTP {
   struct PendingResponse {
     const Request request;
     Response response;
+
+    PendingResponse(const Request& request, const Route* route)
+      : request(request), response(this->request, route) {}
+  private:
+    PendingResponse(const PendingResponse& other);
+    PendingResponse& operator=(const PendingResponse& other);
   };
-}
\ No newline at end of file
+}
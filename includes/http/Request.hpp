@@ -4,7 +4,9 @@
  * It stores an HTTP Request.
  * Has a bunch of helper methods.
  * Also stores the client socket.
- * The body is stored as a ByteStream.
+ * Params (query & form) are parsed once, copies take them as they are.
+ * Handlers are given the connection's HTTP::PendingRequest itself, not a copy.
+ * The body is stored as a HTTP::RequestBody (memory or temp file, shared between copies).
 */
 #pragma once
 
@@ -17,6 +19,7 @@
 
 #include "Methods.hpp"
 #include "Headers.hpp"
+#include "RequestBody.hpp"
 
 namespace HTTP {
 
@@ -31,12 +34,14 @@ namespace HTTP {
         name(name), path(path), data(data) {}
     };
   public:
+    // empty, see HTTP::PendingRequest
+    Request();
     Request(
       Socket::Parallel* server,
       Socket::Connection* client,
       Methods::Method method,
       const std::string& path,
-      const ByteStream& body,
+      const RequestBody& body,
       const std::string& protocol,
       const Headers& headers,
       const std::map<std::string, std::string>& params,
@@ -55,12 +60,9 @@ namespace HTTP {
     Socket::Connection& getClient();
     const Socket::Server& getServer() const;
     Socket::Server& getServer();
-    inline const ByteStream& getRawBody() const {
+    inline const RequestBody& getBody() const {
       return this->body;
     }
-    inline const std::string getBody() const {
-      return this->body.toString();
-    }
 
     template <typename T>
     T getParam(const std::string& key) const {
@@ -97,27 +99,34 @@ namespace HTTP {
       return this->getHeaders().get<std::string>("Content-Type");
     }
     inline int getContentLength() const {
-      return this->getHeaders().has("Content-Length") ? this->getHeaders().get<int>("Content-Length") : 0;
+      uint64_t length = 0;
+      this->getHeaders().getNumber(Headers::Names::ContentLength, length);
+      return length;
     }
 
     inline bool isExpecting() const {
-      return this->getHeaders().has("Expect") && this->getContentLength() > 0;
+      return this->getHeaders().has(Headers::Names::Expect) && this->getContentLength() > 0;
     }
+    // based on the Connection header & protocol, persistent by default since HTTP/1.1
+    bool isKeepAlive() const;
 
     friend std::ostream& operator<<(std::ostream& os, const Request& request);
   protected:
     Headers headers;
     Methods::Method method;
     std::string path;
-    ByteStream body;
+    RequestBody body;
     std::string protocol;
     Socket::Parallel* server;
     Socket::Connection* client;
     std::map<std::string, std::string> params;
     std::vector<File> files;
 
-    Request();
     void parseParams();
+    // splits the query out of path, then decodes & resolves it
+    void parseQuery();
+    // from a x-www-form-urlencoded body
+    void parseBodyParams();
 
     friend class Response;
   };
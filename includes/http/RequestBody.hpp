@@ -0,0 +1,65 @@
+/**
+ * RequestBody.hpp
+ * Storage of a HTTP::Request body, filled as the body arrives.
+ * Small bodies are kept in memory, once a body grows past http.request_body.max_memory
+ * it is spilled to a temp file (in http.request_body.temp_dir) & the rest is appended to it.
+ * Copies share the same storage (refcounted), so requests can be copied around
+ * without copying their body, the temp file is removed with the last reference.
+ * The storage is only allocated on the first write, empty bodies cost nothing.
+ * Handlers either read it from memory or take the file (uploads rename it, CGI reads it as stdin).
+*/
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include <ByteStream.hpp>
+
+namespace HTTP {
+  class RequestBody {
+  public:
+    RequestBody();
+    ~RequestBody();
+    RequestBody(const RequestBody& other);
+    RequestBody& operator=(const RequestBody& other);
+
+    // throws if the temp file can't be created or written to
+    void write(const void* data, uint64_t size);
+    // drops the content, other copies keep theirs
+    void clear();
+
+    inline uint64_t size() const { return this->storage ? this->storage->size : 0; }
+    inline bool empty() const { return this->size() == 0; }
+    // spilled to a temp file
+    inline bool isFile() const { return this->storage && this->storage->fd >= 0; }
+    // empty once spilled
+    inline const ByteStream& getData() const { return this->getStorage().data; }
+    inline const std::string& getPath() const { return this->getStorage().path; }
+
+    // the whole body, read back from the temp file if needed
+    std::string toString() const;
+    /*
+     * Moves the body to path, renaming the temp file if there is one.
+     * The body is empty afterwards, returns false (with errno set) on failure.
+     */
+    bool saveTo(const std::string& path);
+  private:
+    struct Storage {
+      ByteStream data;
+      int fd;
+      std::string path;
+      uint64_t size;
+      uint32_t refs;
+
+      Storage();
+      ~Storage();
+    };
+    // NULL until written to
+    Storage* storage;
+
+    // a shared empty one if there is none yet
+    const Storage& getStorage() const;
+
+    void spill();
+    void release();
+  };
+}
@@ -0,0 +1,88 @@
+/**
+ * RequestParser.hpp
+ * Incremental parser of an HTTP/1.1 request head (request line & headers).
+ * It scans the connection's read buffer in place, without consuming nor copying anything,
+ * and resumes where it stopped when more data arrives.
+ * Everything it finds is stored as spans (offsets into the buffer, which may grow in between calls),
+ * strings are only built when asked for.
+ * Once the head is done, the caller consumes getHeadSize() bytes & resets the parser.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <ByteStream.hpp>
+
+#include "Methods.hpp"
+
+namespace HTTP {
+  class RequestParser {
+  public:
+    struct Span {
+      uint64_t offset;
+      uint64_t size;
+
+      Span() : offset(0), size(0) {}
+      Span(uint64_t offset, uint64_t size) : offset(offset), size(size) {}
+    };
+    struct Header {
+      Span name;
+      Span value;
+    };
+    struct Results {
+      enum Result {
+        Incomplete,
+        Done,
+        Error
+      };
+    };
+    struct States {
+      enum State {
+        RequestLine,
+        Headers,
+        Done
+      };
+    };
+
+    static const uint64_t npos = static_cast<uint64_t>(-1);
+
+    // returns the offset of the CRLF ending the line starting at from, npos if there is none yet
+    static uint64_t FindLine(const ByteStream& buffer, uint64_t from);
+    static std::string ToString(const ByteStream& buffer, const Span& span);
+
+    RequestParser();
+    ~RequestParser();
+    RequestParser(const RequestParser& other);
+    RequestParser& operator=(const RequestParser& other);
+
+    void reset();
+    Results::Result parse(const ByteStream& buffer);
+
+    inline States::State getState() const { return this->state; }
+    inline Methods::Method getMethod() const { return this->method; }
+    inline const Span& getTarget() const { return this->target; }
+    inline const Span& getProtocol() const { return this->protocol; }
+    inline const std::vector<Header>& getHeaders() const { return this->headers; }
+    inline uint64_t getHeadSize() const { return this->cursor; }
+    // status code & reason of the last Error result
+    inline int getErrorCode() const { return this->errorCode; }
+    inline const std::string& getError() const { return this->error; }
+  private:
+    States::State state;
+    // start of the line being parsed
+    uint64_t cursor;
+    // where the search for the end of line resumes
+    uint64_t scanned;
+    Methods::Method method;
+    Span target;
+    Span protocol;
+    std::vector<Header> headers;
+    int errorCode;
+    std::string error;
+
+    bool parseRequestLine(const char* data, const Span& line);
+    bool parseHeader(const char* data, const Span& line);
+    bool fail(int code, const std::string& error);
+  };
+}
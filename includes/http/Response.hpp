@@ -4,6 +4,8 @@
  * It handles an HTTP Response.
  * Based on NodeJS's http.ServerResponse.
  * It is used to build a response to send to the client.
+ * The default headers are set once on construction, copies take them as they are.
+ * Its headers can live in the request's arena, copies then keep their own (see HTTP::Headers).
 */
 #pragma once
 
@@ -17,6 +19,8 @@
 #include "Headers.hpp"
 #include "Request.hpp"
 #include "Route.hpp"
+#include "FileCache.hpp"
+#include "ResponseCache.hpp"
 
 namespace HTTP {
   class Request;
@@ -25,6 +29,8 @@ namespace HTTP {
   public:
 
     Response(const Request& req, const Route* route);
+    // headers are allocated from arena, it must outlive the response
+    Response(const Request& req, const Route* route, Utils::Arena& arena);
     ~Response();
     Response(const Response& other);
     Response& operator=(const Response& other);
@@ -83,21 +89,29 @@ namespace HTTP {
       this->send();
     }
     void sendHeader();
+    // Connection & Keep-Alive, from the request & its client's keep-alive limits
+    void setupConnectionHeaders();
 
     friend std::ostream& operator<<(std::ostream& stream, const Response& response);
   private:
-    void _sendChunk(const char* buffer, std::istream& buff, bool last = false);
     void _preSend();
     void _preStream(const std::string& filePath);
+    void _sendRawFile(const std::string& filePath);
+    uint64_t _getChunkSize(uint64_t fileSize) const;
   public:
     void setupStaticFileHeaders(const std::string& filePath, struct stat* fileStat = nullptr);
-
-    void stream(std::istream& buff, size_t fileSize = 0);
+    void setupStaticFileHeaders(const FileCache::Entry& file);
 
     /**
-     * bool stream parameter is deprecated and overriden to true.
+     * When stream is true, the file is sent with chunked encoding,
+     * its chunks are read as the client's write queue drains.
+     * Otherwise it is sent as is with Content-Length, straight from the fd with sendfile
+     * (through the FileCache, fileStat is then unused).
     */
     void sendFile(const std::string& filePath, bool stream = true, struct stat* fileStat = nullptr);
+    void sendFile(const FileCache::Entry& file);
+    // sends a pre-serialized response, only Date, Connection & Keep-Alive are added to it
+    void sendCached(const ResponseCache::Entry& entry);
     void redirect(const std::string& path, bool permanent = true);
   private:
     Response();
@@ -0,0 +1,64 @@
+/**
+ * ResponseCache.hpp
+ * Per route LRU cache of fully serialized 200 responses for small static files.
+ * Each entry holds the status line, the headers (minus Date, Connection & Keep-Alive)
+ * and the file content in a single shared buffer,
+ * a hit hands ranges of it to the write queue without copying or rebuilding anything.
+ * Entries are dropped when the file's mtime, size or inode change (as seen by the FileCache).
+*/
+#pragma once
+
+#include <string>
+#include <map>
+#include <list>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <socket/WriteQueue.hpp>
+
+#include "FileCache.hpp"
+
+namespace HTTP {
+  class Response;
+
+  class ResponseCache {
+  public:
+    struct Entry {
+      std::string path;
+      struct stat st;
+      // status line, headers & body
+      Socket::WriteQueue::SharedBuffer* response;
+      // where the per request headers go, right before the empty line
+      uint64_t headerSize;
+      inline uint64_t size() const { return this->response->get().size(); }
+    };
+
+    ResponseCache(uint64_t maxFileSize, uint64_t maxMemory);
+    ~ResponseCache();
+
+    /*
+     * Returns the cached response of file, building it from res' headers on a miss.
+     * NULL if the file isn't cacheable (too big or unreadable).
+     * The pointer stays valid until the next call to get or invalidate.
+     */
+    const Entry* get(const FileCache::Entry& file, const Response& res);
+    void invalidate(const std::string& path);
+    void clear();
+
+    inline uint64_t getMemoryUsage() const { return this->memory; }
+  private:
+    ResponseCache(const ResponseCache& other);
+    ResponseCache& operator=(const ResponseCache& other);
+
+    typedef std::list<Entry*> List;
+
+    // most recently used first
+    List lru;
+    std::map<std::string, List::iterator> entries;
+    uint64_t maxFileSize;
+    uint64_t maxMemory;
+    uint64_t memory;
+
+    Entry* load(const FileCache::Entry& file, const Response& res);
+    void evict(List::iterator it);
+  };
+}
@@ -6,6 +6,8 @@
  * If n module doesn't handle the request (and the configuration allows), it will bounce the request to n + 1 module.
  * If no module handles the request, it will send a 404 Not Found.
  * If a module handles the request but the default protections are not met, it will send the appropriate error code (or bounce to the next one).
+ * Its settings (merged with the default route's) are compiled into plain fields on init,
+ * request handling never reads the YAML.
 */
 
 #pragma once
@@ -17,6 +19,7 @@
 #include <utils/misc.hpp>
 
 #include <iostream>
+#include <map>
 
 namespace HTTP {
   class ServerConfiguration;
@@ -32,14 +35,16 @@ namespace HTTP {
     Route(const ServerConfiguration* server, const YAML::Node& node);
     virtual ~Route();
     Route(const Route& other);
-    inline const std::string& getUri() const { return this->node["uri"].getValue(); }
+    inline const std::string& getUri() const { return this->uri; }
 
     inline const YAML::Node& getSettings() const { return this->node["settings"]; }
     // settings quick getters
-    bool hasErrorPage(int code) const;
+    inline bool hasErrorPage(int code) const { return this->errorPages.count(code) > 0; }
     const std::string& getErrorPage(int code) const;
-    uint32_t getMaxBodySize() const;
-    bool isMethodAllowed(Methods::Method method) const;
+    inline uint32_t getMaxBodySize() const { return this->maxBodySize; }
+    inline bool isMethodAllowed(Methods::Method method) const {
+      return method != Methods::UNK && (this->methods & Methods::ToBit(method)) != 0;
+    }
 
     void handle(const Request& req, Response& res) const;
     Routing::Module* getModule(const Routing::Types::Type type) const;
@@ -50,7 +55,13 @@ namespace HTTP {
     const ServerConfiguration* server;
     const YAML::Node& node;
     std::vector<Routing::Module*> modules;
+    std::string uri;
+    // Methods::ToBit of each allowed one
+    uint32_t methods;
+    uint32_t maxBodySize;
+    std::map<int, std::string> errorPages;
 
+    void compileSettings();
     void addModule(Routing::Module* module);
     void initModule(const YAML::Node& node);
 
@@ -0,0 +1,48 @@
+/**
+ * RouteTrie.hpp
+ * Radix trie over the route uris of a server, built once when its routes are initialized.
+ * Finding the route of a path is a single walk over its bytes, without allocating:
+ * the deepest route that ends at a path segment boundary wins, i.e. /a/b/c & /a/b/ match /a/b, /a/bc doesn't.
+ * Routes aren't owned, the trie only points to them.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace HTTP {
+  class Route;
+  class RouteTrie {
+  public:
+    RouteTrie();
+    ~RouteTrie();
+
+    // false if uri already has a route
+    bool insert(const std::string& uri, const Route* route);
+    // nearest route of path, NULL if there is none
+    const Route* find(const char* path, size_t size) const;
+    inline const Route* find(const std::string& path) const {
+      return this->find(path.data(), path.size());
+    }
+    void clear();
+  private:
+    struct Node {
+      // bytes of the edge leading to this node
+      std::string label;
+      const Route* route;
+      // sorted by the first byte of their labels
+      std::vector<Node*> children;
+
+      Node(const std::string& label, const Route* route = NULL);
+      ~Node();
+      // the child whose label starts with c, NULL if there is none
+      Node* child(char c) const;
+      void addChild(Node* node);
+    };
+    Node* root;
+
+    RouteTrie(const RouteTrie&);
+    RouteTrie& operator=(const RouteTrie&);
+  };
+}
@@ -18,6 +18,7 @@
 #include "http/Request.hpp"
 #include "http/Response.hpp"
 #include "http/Route.hpp"
+#include "http/RouteTrie.hpp"
 #include "http/routes/Default.hpp"
 
 #include <map>
@@ -31,7 +32,6 @@ namespace HTTP {
     ~ServerConfiguration();
     ServerConfiguration(const ServerConfiguration& other);
 
-    bool match(const Request& req) const;
     const std::vector<Socket::Host>& getHosts() const;
     const std::vector<std::string>& getNames() const;
     bool hasName(const std::string& name) const;
@@ -42,12 +42,17 @@ namespace HTTP {
       return this->config["settings"];
     }
     int getMaxConnections() const;
+    // both resolved on init
+    inline int getKeepAliveTimeout() const { return this->keepAliveTimeout; }
+    inline uint32_t getMaxRequestsPerConnection() const { return this->maxRequestsPerConnection; }
 
     const Route* getRoute(const std::string& path) const;
 
-    // will search for the nearest route, i.e. /a/b/c will match /a/b route
+    // will search for the nearest route, i.e. /a/b/c will match /a/b route (see RouteTrie)
     const Route* getNearestRoute(const std::string& path) const;
     const Routes::Default* getDefaultRoute() const;
+    // of the route path would be handled by, 0 for unlimited
+    uint32_t getMaxBodySize(const std::string& path) const;
 
     void handleRequest(const Request& req, Response& res) const;
     void init();
@@ -66,5 +71,8 @@ namespace HTTP {
     bool defaultHost;
     Routes::Default* defaultRoute;
     std::map<std::string, const Route*> routes;
+    RouteTrie routeTrie;
+    int keepAliveTimeout;
+    uint32_t maxRequestsPerConnection;
   };
 }
\ No newline at end of file
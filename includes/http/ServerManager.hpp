@@ -3,14 +3,19 @@
  * The HTTP::ServerManager class is a Singleton that manages multiple ServerConfigurations.
  * It uses the HTTP::WebSocket class with inheritance to create & manage all pending requests.
  * When a HTTP Request is received, the class will call the onRequest method.
- * It will choose the best ServerConfiguration to handle the request.
+ * It will choose the best ServerConfiguration to handle the request,
+ * through a hash table of (listen address, server name) built when the configuration is loaded.
  * If no ServerConfiguration is found, it will use the default one.
  * Upon selecting the ServerConfiguration, it will call the onRequest method.
+ * When more than one worker is configured, the process forks into N workers after loading the config,
+ * each one binding its own listeners (SO_REUSEPORT) & running its own event loop,
+ * while the original process only supervises them.
 */
 #pragma once
 
 #include <utils/Instance.hpp>
 #include "WebSocket.hpp"
+#include "VirtualHosts.hpp"
 
 #include <vector>
 
@@ -33,22 +38,30 @@ namespace HTTP {
     inline uint64_t getEnvSize() const { return this->envSize; }
     void setEnv(char** env);
     bool loadConfig(const std::string& path);
+    void spawnWorkers();
+    int waitWorkers();
+    inline bool isSupervisor() const { return this->supervisor; }
+    inline int getWorkerId() const { return this->workerId; }
     void bindServers();
   private:
     friend class ::Instance;
     ServerManager();
     virtual void onRequest(const Request& req, Response& res);
+    virtual size_t getMaxBodySize(const Request& req) const;
     ServerConfiguration* selectServer(const Request& req) const;
-    ServerConfiguration* getDefaultServer(const Socket::Host host) const;
+    ServerConfiguration* getDefaultServer(const Socket::Host& host) const;
 
     void addServer(const YAML::Node& node);
 
     static void onSIGINT(int signum);
   private:
     std::vector<ServerConfiguration*> servers;
-    std::map<Socket::Host, ServerConfiguration*> defaultServers;
+    VirtualHosts virtualHosts;
     const YAML::Node root;
     char** env;
     uint64_t envSize;
+    bool supervisor;
+    int workerId;
+    std::vector<pid_t> workers;
   };
 };
\ No newline at end of file
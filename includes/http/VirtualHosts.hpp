@@ -0,0 +1,52 @@
+/**
+ * VirtualHosts.hpp
+ * Hash table from (listen address, server name) to the server configuration handling it,
+ * built once by the HTTP::ServerManager after loading the configuration.
+ * Names are case insensitive & looked up straight from the Host header bytes, no allocation.
+ * Each listen address also has a default server, used when no name matches.
+ * Open addressing, kept at most half full.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include <utils/misc.hpp>
+#include <socket/Types.hpp>
+
+namespace HTTP {
+  class ServerConfiguration;
+  class VirtualHosts {
+  public:
+    VirtualHosts();
+    ~VirtualHosts();
+
+    // false if name is already taken on host, the first one is kept
+    bool insert(const Socket::Host& host, const std::string& name, ServerConfiguration* server);
+    void setDefault(const Socket::Host& host, ServerConfiguration* server);
+    // NULL if there is none
+    ServerConfiguration* find(const Socket::Host& host, const char* name, size_t size) const;
+    ServerConfiguration* getDefault(const Socket::Host& host) const;
+    void clear();
+  private:
+    struct Slot {
+      uint32_t hash;
+      Socket::Host host;
+      // lowercased, empty for the default server of host
+      std::string name;
+      ServerConfiguration* server;
+
+      Slot();
+    };
+    std::vector<Slot> slots;
+    size_t count;
+
+    static uint32_t Hash(const Socket::Host& host, const char* name, size_t size);
+    // the slot of (host, name), or the empty one it would go in
+    size_t probe(uint32_t hash, const Socket::Host& host, const char* name, size_t size) const;
+    Slot& at(const Socket::Host& host, const std::string& name);
+    void grow();
+  };
+}
@@ -2,9 +2,17 @@
  * WebSocket.hpp
  * The HTTP::WebSocket class is used to manage multiple pending HTTP::Request & HTTP::Response.
  * It uses the Socket::Parallel class with inheritance to manage all opened connections (sockets) & cgi processes.
- * When a socket packet is received, the class will parse it as an HTTP Request.
+ * When a socket packet is received, the class will parse it as an HTTP Request (see HTTP::RequestParser).
  * While building the request, if something is wrong, the class will send a HTTP::Response and close the connection.
+ * Once the headers are parsed, the body size limit of the request's route is looked up (getMaxBodySize),
+ * bodies going over it are answered with 413 before being read.
  * If the HTTP Request is valid, the class will call the onRequest method.
+ * Pipelined requests are handled one after the other from the same read buffer,
+ * parsing pauses while a CGI response is pending so responses stay in order.
+ * It also owns the FastCGI pools of the interpreters running with mode: fastcgi,
+ * their workers are driven from its event loop as upstream files (see HTTP::FastCGI).
+ * Each connection keeps its HTTP::PendingRequest, handed to onRequest as is & reset afterwards,
+ * along with the connection's arena (see Utils::Arena).
 */
 #pragma once
 
@@ -20,17 +28,39 @@
 #include "PendingResponse.hpp"
 
 namespace HTTP {
+  namespace FastCGI {
+    class Pool;
+    class Job;
+  }
+
   class WebSocket : public Socket::Parallel {
   private:
     std::map<int, PendingRequest> pendingRequests;
-    std::map<pid_t, PendingResponse> pendingCGIResponses;
+    // built in place, owned
+    std::map<pid_t, PendingResponse*> pendingCGIResponses;
     std::map<int, pid_t> pendingCGIProcesses;
+    // keyed by the command of the workers, owned
+    std::map<std::string, FastCGI::Pool*> fastCGIPools;
+    // by client, owned by their pool
+    std::map<int, FastCGI::Job*> pendingFastCGIJobs;
+    // while its job is handed to a pool, -1 otherwise
+    int submittingClient;
   public:
     WebSocket();
     ~WebSocket();
     virtual void onRequest(const Request& req, Response& res) = 0;
+    // of the route that will handle req (only its head is parsed), 0 for unlimited
+    virtual size_t getMaxBodySize(const Request& req) const = 0;
 
     void trackCGIResponse(pid_t pid, int std[2], Response& res);
+    // the pool of workers running path with args, created on first use
+    FastCGI::Pool& getFastCGIPool(const std::string& path, const std::vector<std::string>& args, int minWorkers, int maxWorkers);
+    // spawns the min workers of every pool, in the process running the event loop
+    void startFastCGIPools();
+    // false if the pool has no worker to run it, a response must be sent by the caller
+    // bodyFd (-1 if none) is owned either way
+    bool trackFastCGIResponse(FastCGI::Pool& pool, ByteStream& params, int bodyFd, Response& res);
+    void onFastCGIExit(FastCGI::Job& job, Socket::Process::ExitCodes::Code code);
   private:
     virtual void onClientConnect(const Socket::Connection& sock);
     virtual bool onClientDisconnect(Socket::Connection& sock);
@@ -39,9 +69,17 @@ namespace HTTP {
     virtual void onProcessRead(Socket::Process& process);
     virtual void onProcessWrite(Socket::Process&, int) {}
     virtual void onProcessExit(const Socket::Process& process, Socket::Process::ExitCodes::Code code = Socket::Process::ExitCodes::Force);
+    virtual void onUpstreamEvent(const Socket::File& file);
+    virtual void onUpstreamTimeout(Socket::Timer& timer);
 
     void handleClientPacket(Socket::Connection& sock);
+    // returns true once a whole request was parsed & handed to onRequest
+    bool handleRequest(Socket::Connection& sock, ByteStream& packet);
+    // both return Error when a response was sent & the request dropped
+    RequestParser::Results::Result parseHead(Socket::Connection& sock, PendingRequest& pendingRequest, ByteStream& packet);
+    RequestParser::Results::Result parseBody(Socket::Connection& sock, PendingRequest& pendingRequest, ByteStream& packet);
 
     void sendBadRequest(Socket::Connection& sock, int statusCode, const std::string& logMsg);
+    void sendCGIResponse(Response& res, Socket::Process::ExitCodes::Code code);
   };
 };
\ No newline at end of file
@@ -35,7 +35,7 @@ namespace HTTP {
           return this->getSettings()["static"]["index"].getValue();
         }
         catch (const std::exception& e) {
-          return Instance::Get<Settings>()->get<std::string>("http.static.default_index");
+          return Instance::Get<Settings>()->getSnapshot().defaultIndex;
         }
       }
       inline bool hasDirectoryListing() const {
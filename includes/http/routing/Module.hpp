@@ -1,6 +1,7 @@
 /**
  * Module.hpp
  * Abstract Class for a Route Module.
+ * Like routes, modules compile their settings into plain fields on init (see Route).
 */
 
 #pragma once
@@ -36,7 +37,9 @@ namespace HTTP {
       virtual inline bool supportsExpect() const { return false; }
       // not related to 405.
       // if returns false, it will skip to the next module
-      bool isMethodAllowed(Methods::Method method) const;
+      inline bool isMethodAllowed(Methods::Method method) const {
+        return method != Methods::UNK && (this->methods & Methods::ToBit(method)) != 0;
+      }
 
       virtual Module* clone() const = 0;
 
@@ -46,10 +49,13 @@ namespace HTTP {
       const Types::Type type;
       const Route& route;
       const YAML::Node& node;
+      // Methods::ToBit of each allowed one
+      uint32_t methods;
+      Middleware noMatch;
 
       virtual void init();
 
-      Middleware getNoMatch() const;
+      inline Middleware getNoMatch() const { return this->noMatch; }
 
     public:
       friend std::ostream& operator<<(std::ostream& os, const Module& module);
@@ -2,6 +2,8 @@
  * CGI.hpp
  * CGI Module for a Route.
  * It handles CGI scripts, interpretation, running & responses.
+ * Interpreters run a process per request by default (mode: cgi),
+ * or hand requests to a pool of persistent FastCGI workers (mode: fastcgi, see HTTP::FastCGI).
 */
 
 #pragma once
@@ -19,6 +21,9 @@
 
 
 namespace HTTP {
+  namespace FastCGI {
+    class Pool;
+  }
   namespace Routing {
     class CGI : public Module {
     public:
@@ -36,20 +41,40 @@ namespace HTTP {
     public:
       class Interpreter {
       public:
+        struct Modes {
+          enum Mode {
+            CGI,
+            FastCGI
+          };
+        };
         Interpreter(const YAML::Node& node);
         ~Interpreter();
         Interpreter(const Interpreter& other);
 
-        inline const std::string& getName() const { return this->node["name"].getValue(); }
-        inline const std::string& getPath() const { return this->node["path"].getValue(); }
-        inline const YAML::Node& getExtensions() const { return this->node["extensions"]; }
-        inline const YAML::Node& getArgs() const { return this->node["args"]; }
+        inline const std::string& getName() const { return this->name; }
+        inline const std::string& getPath() const { return this->path; }
+        inline const std::vector<std::string>& getExtensions() const { return this->extensions; }
+        inline const std::vector<std::string>& getArgs() const { return this->args; }
+        inline Modes::Mode getMode() const { return this->mode; }
+        inline int getMinWorkers() const { return this->minWorkers; }
+        inline int getMaxWorkers() const { return this->maxWorkers; }
         bool hasExtension(const std::string& ext) const;
 
         bool run(const std::string& filePath, const Request& req, Response& res, const CGI* cgi) const;
       private:
         void init();
+        bool runFastCGI(const std::string& filePath, const Request& req, Response& res, const CGI* cgi) const;
         const YAML::Node& node;
+        std::string name;
+        std::string path;
+        std::vector<std::string> extensions;
+        // of the script in cgi mode, of the worker in fastcgi mode
+        std::vector<std::string> args;
+        Modes::Mode mode;
+        int minWorkers;
+        int maxWorkers;
+        // fastcgi mode only, shared by the interpreters running the same command
+        FastCGI::Pool* pool;
       };
     public:
       CGI(const Route& route, const YAML::Node& node);
@@ -59,8 +84,8 @@ namespace HTTP {
       inline bool supportsExpect() const { return true; }
       inline CGI* clone() const { return new CGI(*this); }
 
-      inline const std::string& getRoot() const { return this->getSettings()["root"].getValue(); }
-      const std::string& getBasePathInfo() const; 
+      inline const std::string& getRoot() const { return this->root; }
+      inline const std::string& getBasePathInfo() const { return this->basePathInfo; }
       inline const std::vector<Interpreter>& getInterpreters() const { return this->interpreters; }
       inline bool isExtMapped(const std::string& ext) const { return this->interpreterExtMap.count(ext) > 0; }
       bool doesFileMatch(const std::string& path) const;
@@ -78,8 +103,13 @@ namespace HTTP {
       std::vector<std::string> resolvePathInfo(const Request& req) const;
       std::string resolvePathTranslated(const Request& req, const std::string& pathInfo) const;
       void generateEnvironment(std::vector<std::string>& env, const Request& req) const;
+      // the request meta-variables only, without the server environment
+      void generateParams(std::vector<EnvVar>& params, const Request& req) const;
       std::vector<std::string> generateArgs(const std::string& path, const Interpreter* interpreter, const Request& req) const;
     private:
+      std::string root;
+      // path_info, the root if unset
+      std::string basePathInfo;
       std::vector<Interpreter> interpreters;
       std::map<std::string, const Interpreter*> interpreterExtMap;
     };
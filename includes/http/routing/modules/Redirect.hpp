@@ -18,14 +18,18 @@ namespace HTTP {
 
       inline Redirect* clone() const { return new Redirect(*this); }
 
-      inline const std::string& getRedirectUri() const {
-        return this->getSettings()["uri"].getValue();
-      }
-      bool isRedirectPartial() const;
+      inline const std::string& getRedirectUri() const { return this->uri; }
+      inline bool isRedirectPartial() const { return this->partial; }
       std::string buildRedirectPath(const Request& req) const;
-      bool isRedirectPermanent() const;
+      inline bool isRedirectPermanent() const { return this->permanent; }
 
       bool handle(const Request& req, Response& res) const;
+    private:
+      std::string uri;
+      bool partial;
+      bool permanent;
+
+      void init();
     };
   }
 }
\ No newline at end of file
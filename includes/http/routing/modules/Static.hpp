@@ -5,11 +5,15 @@
  * Has support for GET, POST, PUT, DELETE & HEAD
  * Has support for Expect: 100-continue
  * Has support for static file caching (with ETag & Last-Modified)
+ * Files are looked up through the FileCache, hot ones are served without a stat
+ * Small files can have their whole 200 response cached (opt-in, see cache setting)
 */
 #pragma once
 
 #include "http/routing/Module.hpp"
 #include "http/DirectoryBuilder.hpp"
+#include "http/FileCache.hpp"
+#include "http/ResponseCache.hpp"
 
 #include <string>
 #include <fstream>
@@ -29,14 +33,24 @@ namespace HTTP {
       inline bool supportsExpect() const { return true; }
       inline Static* clone() const { return new Static(*this); }
 
-      const std::string& getRoot() const;
-      const std::string getIndex() const;
-      const std::string& getRedirection() const;
-      bool isDirectoryListingAllowed() const;
-      bool ignoreHiddenFiles() const;
+      inline const std::string& getRoot() const { return this->root; }
+      inline const std::string& getIndex() const { return this->index; }
+      inline const std::string& getRedirection() const { return this->redirection; }
+      inline bool isDirectoryListingAllowed() const { return this->directoryListing; }
+      inline bool ignoreHiddenFiles() const { return this->ignoreHidden; }
+      inline bool isCacheEnabled() const { return this->cache != NULL; }
 
       bool handle(const Request& req, Response& res) const;
     private:
+      // NULL unless the cache setting is enabled
+      ResponseCache* cache;
+      std::string root;
+      std::string index;
+      // send_to, the root if unset
+      std::string redirection;
+      bool directoryListing;
+      bool ignoreHidden;
+
       void init();
 
       std::string getResolvedPath(const Request& req) const;
@@ -45,8 +59,8 @@ namespace HTTP {
       bool handleGet(const std::string& path, const Request& req, Response& res) const;
       bool handleUploads(const std::string& path, const Request& req, Response& res) const;
       bool handleDelete(const std::string& path, const Request& req, Response& res) const;
-      bool handleFile(const std::string& path, const Request& req, Response& res) const;
-      bool clientHasFile(const Request& req, const std::string& filePath, struct stat* st) const;
+      bool handleFile(const FileCache::Entry& file, const Request& req, Response& res) const;
+      bool clientHasFile(const Request& req, const FileCache::Entry& file) const;
     };
   }
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+/**
+ * scan.hpp
+ * Byte scanning kernels used by the request parser.
+ * They look for delimiters (CRLF, ':', quotes) & invalid token bytes
+ * 32 (AVX2) or 16 (SSE2) bytes at a time, with a scalar fallback.
+ * The kernel is picked once at runtime, based on what the CPU supports.
+ * Single bytes are classified with a 256-entry table.
+*/
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+namespace HTTP {
+  namespace Scan {
+    struct Kernels {
+      enum Kernel {
+        Scalar,
+        SSE2,
+        AVX2
+      };
+      static std::string ToString(Kernel kernel);
+    };
+    struct Classes {
+      enum Class {
+        // see specialFieldTokens
+        FieldToken = 1 << 0,
+        // see specialUriTokens
+        UriToken = 1 << 1
+      };
+    };
+
+    Kernels::Kernel getKernel();
+
+    bool is(char c, Classes::Class cls);
+
+    // all return the index of the first match, size if there is none
+    size_t find(const char* data, size_t size, char c);
+    size_t findNonFieldToken(const char* data, size_t size);
+    size_t findNonUriToken(const char* data, size_t size);
+  }
+}
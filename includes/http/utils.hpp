@@ -13,9 +13,11 @@ namespace HTTP {
     = "!#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
   bool hasFieldToken(char c);
   bool hasFieldToken(const std::string& str);
+  bool hasFieldToken(const char* str, size_t size);
 
   bool hasDisallowedUriToken(char c);
   bool hasDisallowedUriToken(const std::string& str);
+  bool hasDisallowedUriToken(const char* str, size_t size);
 
   std::string& capitalizeHeader(std::string& str);
 }
\ No newline at end of file
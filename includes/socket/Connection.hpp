@@ -1,17 +1,23 @@
 /**
  * Connection.hpp
  * A class to represent a client socket connection.
- * Stores pending read & write buffers.
+ * Stores the pending read buffer & the outbound write queue.
  * Stores the client socket fd.
  * Also has some helper methods & timeout functionality.
+ * Counts the requests it carried, for keep-alive limits.
+ * Its timer is rescheduled in the Parallel timer wheel on every ping.
+ * Owns an arena for the request being handled, reset once it is done (see Utils::Arena).
 */
 #pragma once
 
 #include <string>
 #include <sstream>
 #include <utils/misc.hpp>
+#include <utils/Arena.hpp>
 
 #include "FileManager.hpp"
+#include "TimerWheel.hpp"
+#include "WriteQueue.hpp"
 
 namespace Socket {
   class Connection {
@@ -19,13 +25,19 @@ namespace Socket {
     File& handle;
     int serverSock;
     ByteStream readBuffer;
-    ByteStream writeBuffer;
+    WriteQueue writeQueue;
+    Utils::Arena arena;
 
     std::string address;
     int port;
 
     int timeout;
     uint64_t heartbeat;
+    Timer timer;
+
+    uint32_t requests;
+    // 0 for unlimited
+    uint32_t maxRequests;
 
     bool closeOnEmptyWriteBuffer;
   public:
@@ -43,9 +55,17 @@ namespace Socket {
     int getPort() const;
     std::string getIpAddress() const;
     ByteStream& getReadBuffer();
-    ByteStream& getWriteBuffer();
+    WriteQueue& getWriteQueue();
+    inline Utils::Arena& getArena() { return this->arena; }
     int getTimeout() const;
+    // reschedules the timer from the last heartbeat
+    void setTimeout(int timeout);
+    inline uint32_t getRequestCount() const { return this->requests; }
+    inline void countRequest() { this->requests++; }
+    inline uint32_t getMaxRequests() const { return this->maxRequests; }
+    inline void setMaxRequests(uint32_t maxRequests) { this->maxRequests = maxRequests; }
     uint64_t getHeartbeat() const;
+    Timer& getTimer();
     bool isAlive() const;
     bool isReadable() const;
     bool isWritable() const;
@@ -28,27 +28,49 @@
 #define SYS_RECV ::recv
 #define SYS_LISTEN ::listen
 #define SYS_ACCEPT ::accept
+#define SYS_ACCEPT4 ::accept4
 #define SYS_CLOSE ::close
 #define SYS_FNCTL ::fcntl
 #define SYS_POLL ::poll
 #define SYS_BIND ::bind
 
 #include <string>
-#include <set>
+#include <vector>
 
 namespace Socket {
   class File {
+  public:
+    // what the file descriptor is bound to, used to dispatch events without lookups
+    struct Tags {
+      enum Tag {
+        None,
+        Listener,
+        Client,
+        Pipe,
+        // driven by the upper layer, see Parallel::trackUpstream
+        Upstream
+      };
+    };
+  private:
     int fd;
     int events;
+    Tags::Tag tag;
+    void* owner;
+    bool tracked;
   public:
-    File() : fd(-1), events(0) {}
-    File(int fd) : fd(fd), events(0) {}
+    File() : fd(-1), events(0), tag(Tags::None), owner(NULL), tracked(false) {}
+    File(int fd) : fd(fd), events(0), tag(Tags::None), owner(NULL), tracked(false) {}
+    File(int fd, Tags::Tag tag) : fd(fd), events(0), tag(tag), owner(NULL), tracked(true) {}
     ~File() {}
-    File(const File& other) : fd(other.fd), events(other.events) {}
+    File(const File& other) :
+      fd(other.fd), events(other.events), tag(other.tag), owner(other.owner), tracked(other.tracked) {}
     File& operator=(const File& other) {
       if (this == &other) return *this;
       this->fd = other.fd;
       this->events = other.events;
+      this->tag = other.tag;
+      this->owner = other.owner;
+      this->tracked = other.tracked;
       return *this;
     }
 
@@ -57,69 +79,80 @@ namespace Socket {
     inline bool isWritable() const { return this->events & EPOLLOUT; }
     inline bool isClosed() const { return this->events & (EPOLLRDHUP | EPOLLHUP); }
     inline bool isErrored() const { return this->events & EPOLLERR; }
+    // false once the FileManager stopped tracking it (events for it must be ignored)
+    inline bool isTracked() const { return this->tracked; }
+    inline Tags::Tag getTag() const { return this->tag; }
+    template <typename T>
+    inline T& getOwner() const { return *static_cast<T*>(this->owner); }
 
     operator int() const { return this->fd; }
     void setEvents(int events) { this->events = events; }
+    inline void setOwner(void* owner) { this->owner = owner; }
+    inline void untrack() { this->tracked = false; }
   };
 
   template <typename T>
   class FileManager {
     typedef struct epoll_event epoll_event_t;
+  public:
+    struct Stats {
+      // epoll_wait calls that returned events
+      uint64_t batches;
+      // ones that filled the whole events array (more may be pending)
+      uint64_t fullBatches;
+      Stats() : batches(0), fullBatches(0) {}
+    };
+  private:
+    static const int defaultBatchSize = 64;
 
-    std::set<File> fds;
+    // dense table indexed by fd, each slot points to a heap allocated File
+    // (the pointer is also stored in epoll_event.data.ptr)
+    std::vector<File*> files;
+    // files removed during a tick, freed once the tick is over
+    std::vector<File*> released;
+    std::vector<File*> changed;
     int epollFd;
+    // reused by every epoll_wait call, sized once to the batch size
     epoll_event_t* events;
-    int maxEvents;
+    int batchSize;
+    Stats stats;
     bool running;
     int timeout;
 
     T* instance;
-    void (T::* onTick)(const std::vector<File>&);
+    void (T::* onTick)(const std::vector<File*>&);
   public:
     FileManager() :
-      fds(), epollFd(-1),
-      events(new epoll_event_t[0]), maxEvents(0), running(false), timeout(-1),
+      files(), released(), changed(), epollFd(-1),
+      events(new epoll_event_t[defaultBatchSize]), batchSize(defaultBatchSize), stats(),
+      running(false), timeout(-1),
       instance(NULL), onTick(NULL) {
       this->init();
     }
-    FileManager(T* instance, void (T::* onTick)(const std::vector<File>&)) :
-      fds(), epollFd(-1),
-      events(new epoll_event_t[0]), maxEvents(0), running(false), timeout(-1),
+    FileManager(T* instance, void (T::* onTick)(const std::vector<File*>&)) :
+      files(), released(), changed(), epollFd(-1),
+      events(new epoll_event_t[defaultBatchSize]), batchSize(defaultBatchSize), stats(),
+      running(false), timeout(-1),
       instance(instance), onTick(onTick) {
       this->init();
     }
-    FileManager(const FileManager& other) :
-      fds(other.fds), epollFd(other.epollFd),
-      events(new epoll_event_t[other.maxEvents]), maxEvents(other.maxEvents), running(false), timeout(other.timeout),
-      instance(other.instance), onTick(other.onTick) {
-      for (int i = 0; i < this->maxEvents; i++)
-        this->events[i] = other.events[i];
-    }
-    FileManager& operator=(const FileManager& other) {
-      if (this == &other) return *this;
-      this->fds = other.fds;
-      this->epollFd = other.epollFd;
-      if (this->events) delete[] this->events;
-      this->events = new epoll_event_t[other.maxEvents];
-      for (int i = 0; i < this->maxEvents; i++)
-        this->events[i] = other.events[i];
-      this->maxEvents = other.maxEvents;
-      this->timeout = other.timeout;
-      this->instance = other.instance;
-      this->onTick = other.onTick;
-      this->running = false;
-      return *this;
-    }
 
     ~FileManager() {
       this->running = false;
       if (this->events) delete[] this->events;
-      for (std::set<File>::iterator it = this->fds.begin(); it != this->fds.end(); it++) {
-        SYS_CLOSE(*it);
+      for (size_t fd = 0; fd < this->files.size(); fd++) {
+        if (!this->files[fd]) continue;
+        SYS_CLOSE(fd);
+        delete this->files[fd];
       }
+      this->releaseFiles();
       if (this->epollFd != -1) SYS_CLOSE(this->epollFd);
     }
   private:
+    // owns the epoll instance & every File, copying it makes no sense
+    FileManager(const FileManager& other);
+    FileManager& operator=(const FileManager& other);
+
     /*
      * Initializes the epoll pool.
      */
@@ -132,59 +165,78 @@ namespace Socket {
       SYS_FNCTL(this->epollFd, F_SETFD, FD_CLOEXEC);
       std::signal(SIGPIPE, SIG_IGN);
     }
+
+    void releaseFiles() {
+      for (size_t i = 0; i < this->released.size(); i++)
+        delete this->released[i];
+      this->released.clear();
+    }
   public:
+    /*
+     * Drops the epoll instance and creates a fresh one.
+     * Used by forked workers, which must not share the parent's epoll pool.
+     */
+    void reset() {
+      for (size_t fd = 0; fd < this->files.size(); fd++)
+        if (this->files[fd])
+          throw std::runtime_error("Cannot reset a FileManager that is tracking file descriptors");
+      if (this->epollFd != -1) SYS_CLOSE(this->epollFd);
+      this->epollFd = -1;
+      this->init();
+    }
+
     /*
      * Add file descriptor with certain flags to the epoll pool
+     * The tag tells the instance what the fd is bound to, see File::setOwner
      */
-    bool add(int fd, int flags) {
+    bool add(int fd, int flags, File::Tags::Tag tag = File::Tags::None) {
+      if (fd < 0)
+        return false;
       if (this->has(fd))
         this->remove(fd, false);
+      File* file = new File(fd, tag);
       epoll_event_t event;
       event.events = flags;
-      event.data.fd = fd;
+      event.data.ptr = file;
       if (::epoll_ctl(this->epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        delete file;
         return false;
       }
       SYS_FNCTL(this->epollFd, F_SETFD, FD_CLOEXEC);
-      this->fds.insert(File(fd));
-      this->maxEvents++;
-      if (this->events) delete[] this->events;
-      this->events = new epoll_event_t[this->maxEvents];
+      if (static_cast<size_t>(fd) >= this->files.size())
+        this->files.resize(fd + 1, NULL);
+      this->files[fd] = file;
       Logger::debug
         << "Tracking file descriptor " << Logger::param(fd) << std::newl;
       return true;
     }
 
     inline bool has(int fd) const {
-      return this->fds.count(fd) > 0;
+      return fd >= 0 && static_cast<size_t>(fd) < this->files.size() && this->files[fd] != NULL;
     }
 
-    const std::set<File>& getAll() const {
-      return this->fds;
-    }
-    std::set<File>& getAll() {
-      return this->fds;
+    const std::vector<File*>& getAll() const {
+      return this->files;
     }
 
     const File& get(int fd) const {
-      std::set<File>::iterator it = this->fds.find(fd);
-      if (it == this->fds.end()) {
+      if (!this->has(fd)) {
         throw std::runtime_error("File not found");
       }
-      return *it;
+      return *this->files[fd];
     }
 
     File& get(int fd) {
-      std::set<File>::iterator it = this->fds.find(fd);
-      if (it == this->fds.end()) {
+      if (!this->has(fd)) {
         throw std::runtime_error("File not found");
       }
-      return const_cast<File&>(*it);
+      return *this->files[fd];
     }
 
     /*
      * Remove file descriptor from the epoll pool
      * If close is true, the file descriptor will be closed
+     * The File object stays alive (untracked) until the current tick is over
      */
     bool remove(int fd, bool close) {
       if (!this->has(fd)) return false;
@@ -196,12 +248,14 @@ namespace Socket {
           << std::newl;
         return false;
       }
-      this->fds.erase(fd);
+      File* file = this->files[fd];
+      file->untrack();
+      this->released.push_back(file);
+      this->files[fd] = NULL;
       if (close)
         SYS_CLOSE(fd);
-      this->maxEvents--;
-      if (this->events) delete[] this->events;
-      this->events = new epoll_event_t[this->maxEvents];
+      if (!this->running)
+        this->releaseFiles();
       Logger::debug
         << "Stopped tracking file descriptor " << Logger::param(fd) << std::newl;
       return true;
@@ -214,7 +268,7 @@ namespace Socket {
       if (!this->has(fd)) return false;
       epoll_event_t event;
       event.events = flags;
-      event.data.fd = fd;
+      event.data.ptr = this->files[fd];
       if (::epoll_ctl(this->epollFd, EPOLL_CTL_MOD, fd, &event) == -1) {
         return false;
       }
@@ -229,36 +283,62 @@ namespace Socket {
       this->timeout = timeout;
     }
 
+    /*
+     * Max amount of events returned by a single epoll_wait call.
+     * Events left over are returned by the next call.
+     */
+    void setBatchSize(int size) {
+      if (size < 1)
+        throw std::runtime_error("epoll batch size must be positive");
+      if (this->running)
+        throw std::runtime_error("Cannot resize the epoll batch while running");
+      if (size == this->batchSize) return;
+      delete[] this->events;
+      this->events = new epoll_event_t[size];
+      this->batchSize = size;
+    }
+
+    inline int getBatchSize() const { return this->batchSize; }
+    inline const Stats& getStats() const { return this->stats; }
+
     inline void stop() { this->running = false; }
 
     /*
      * Start the epoll loop
      * This function will block until stop() is called
      * If instance is set, the onTick callback will be called every time the epoll pool returns events
-     * Each file descriptor that has events will be processed into a File object
+     * Each event carries a pointer to its File, so no lookup is needed to process it
      * All File objects that changed will be passed to the onTick callback
      */
     void start() {
       if (this->running) return;
       this->running = true;
       while (this->running) {
-        int n = ::epoll_wait(this->epollFd, this->events, this->maxEvents, this->timeout);
+        int n = ::epoll_wait(this->epollFd, this->events, this->batchSize, this->timeout);
         if (n == -1) {
           if (errno == EINTR) continue;
           throw std::runtime_error("epoll_wait failed");
         }
-        std::vector<File> changed(n);
+        if (n > 0)
+          this->stats.batches++;
+        if (n == this->batchSize) {
+          this->stats.fullBatches++;
+          Logger::debug
+            << "epoll batch full (" << Logger::param(n) << " events), "
+            << "the rest will be picked up on the next tick" << std::newl;
+        }
+        this->changed.clear();
         for (int i = 0; i < n; i++) {
           epoll_event_t& event = this->events[i];
-          std::set<File>::iterator it = this->fds.find(event.data.fd);
-          if (it == this->fds.end()) continue;
-          File& file = const_cast<File&>(*it);
-          file.setEvents(event.events);
-          changed[i] = file;
+          File* file = static_cast<File*>(event.data.ptr);
+          if (!file->isTracked()) continue;
+          file->setEvents(event.events);
+          this->changed.push_back(file);
         }
         if (this->instance && this->onTick) {
-          (this->instance->*this->onTick)(changed);
+          (this->instance->*this->onTick)(this->changed);
         }
+        this->releaseFiles();
       }
     }
 
@@ -4,9 +4,13 @@
  * It uses the Socket::FileManager class to manage file descriptors.
  * It also manages processes pipes.
  * When a file descriptor is read, the onTick event is called.
+ * Each File is tagged with what it belongs to, so dispatching needs no lookups.
+ * Client & process timeouts are expired through a TimerWheel, idle ones cost nothing per tick.
  * If the file descriptor is a client socket, the onClient methods are called.
  * If the file descriptor is a server socket, the onNewConnection method is called.
+ * Running out of file descriptors pauses every listener until a client disconnects or a short delay passes.
  * If the file descriptor is a process pipe, the onProcess methods are called.
+ * Upstream file descriptors (i.e. FastCGI workers) & their timers are handed as is to onUpstreamEvent & onUpstreamTimeout.
 */
 
 #pragma once
@@ -14,6 +18,7 @@
 #include "FileManager.hpp"
 #include "Connection.hpp"
 #include "Process.hpp"
+#include "TimerWheel.hpp"
 #include "Types.hpp"
 
 #include <utils/misc.hpp>
@@ -36,10 +41,15 @@ namespace Socket {
   class Parallel {
   private:
     FileManager<Parallel> fileManager;
+    TimerWheel timers;
     std::map<int, Server> servers;
     std::map<int, Connection> clients;
     std::map<std::string, int> addressesToSock;
     int timeout;
+    bool reusePort;
+    // resumes the listeners paused by pauseAccepting
+    Timer acceptTimer;
+    bool acceptPaused;
 
     std::map<pid_t, Process> processes;
     std::map<int, pid_t> pipesToProcesses;
@@ -71,6 +81,13 @@ namespace Socket {
     const Process& getProcessBoundTo(const int pipeFd) const;
     bool trackProcess(const pid_t pid, const Connection& client, int std[2]);
 
+    // owner is what the file is bound to, given back on each event
+    bool trackUpstream(int fd, int flags, void* owner);
+    bool updateUpstream(int fd, int flags);
+    // closes it
+    void untrackUpstream(int fd);
+    void schedule(Timer& timer, uint64_t expiresAt);
+
     const Server& bind(
       const Domain::Handle domain,
       const Type::Handle type,
@@ -90,15 +107,27 @@ namespace Socket {
     inline void stop() {
       this->fileManager.stop();
     }
+    // recreates the epoll pool, must be called before binding in a forked worker
+    inline void reset() {
+      this->fileManager.reset();
+    }
+    inline void setReusePort(bool state) {
+      this->reusePort = state;
+    }
 
     void setClientToRead(Connection& client);
     void setClientToWrite(Connection& client);
 
   private:
 
-    void onTick(const std::vector<File>& changed);
+    void onTick(const std::vector<File*>& changed);
+    void onTimersExpired();
 
     void _onNewConnection(Server& sock);
+    bool _acceptConnection(Server& sock);
+    // stops polling the listeners, pending connections wait in their backlog
+    void pauseAccepting();
+    void resumeAccepting();
     bool _onClientDisconnect(const Connection& sock);
     void _onClientRead(Connection& sock);
     void _onClientWrite(Connection& sock);
@@ -116,6 +145,8 @@ namespace Socket {
     virtual void onProcessRead(Process& process) = 0;
     virtual void onProcessWrite(Process& process, int bytesWritten) = 0;
     virtual void onProcessExit(const Process& process, Process::ExitCodes::Code code = Process::ExitCodes::Force) = 0;
+    virtual void onUpstreamEvent(const File& file) = 0;
+    virtual void onUpstreamTimeout(Timer& timer) = 0;
   };
 
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
  * Similar to Connection.hpp.
  * Stores a CGI process and refs to its pipes (they live in FileManager).
  * Also has some helper methods & timeout functionality.
+ * Its timer is rescheduled in the Parallel timer wheel on every ping.
 */
 #pragma once
 
@@ -15,6 +16,7 @@
 
 #include "FileManager.hpp"
 #include "Connection.hpp"
+#include "TimerWheel.hpp"
 
 namespace Socket {
   class Process {
@@ -39,11 +41,13 @@ namespace Socket {
     ByteStream writeBuffer;
     int timeout;
     uint64_t heartbeat;
+    Timer timer;
 
   public:
+    // out is NULL when the process stdin isn't fed by us (i.e. a file)
     Process(
       File& in,
-      File& out,
+      File* out,
       const Connection& con,
       pid_t id,
       int timeout);
@@ -62,7 +66,13 @@ namespace Socket {
     inline bool hasTimedOut() const {
       return Utils::getCurrentTime() - this->heartbeat >= static_cast<uint32_t>(this->timeout);
     }
-    inline void ping() { this->heartbeat = Utils::getCurrentTime(); }
+    inline int getTimeout() const { return this->timeout; }
+    inline uint64_t getHeartbeat() const { return this->heartbeat; }
+    inline Timer& getTimer() { return this->timer; }
+    inline void ping() {
+      this->heartbeat = Utils::getCurrentTime();
+      this->timer.reschedule(this->heartbeat + this->timeout);
+    }
 
     inline void removeIn() { this->in = nullptr; }
     inline void removeOut() { this->out = nullptr; }
@@ -0,0 +1,91 @@
+/**
+ * TimerWheel.hpp
+ * A hashed timing wheel used to expire connections & processes.
+ * Each Timer is an intrusive node owned by a Connection, a Process, an upstream (see Parallel::trackUpstream)
+ * or the Parallel itself, to resume accepting once it ran out of file descriptors,
+ * so scheduling, rescheduling & cancelling are O(1).
+ * Timers further than one revolution away stay in their slot until their round comes.
+ * Expired timers are moved to a pending list & popped one by one,
+ * so handling one expiration may safely destroy or reschedule other timers.
+*/
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <cstddef>
+
+namespace Socket {
+  class TimerWheel;
+
+  class Timer {
+  public:
+    struct Targets {
+      enum Target {
+        None,
+        Client,
+        Process,
+        Listener,
+        Upstream
+      };
+    };
+  private:
+    friend class TimerWheel;
+
+    Targets::Target target;
+    void* owner;
+    TimerWheel* wheel;
+    Timer* prev;
+    Timer* next;
+    size_t slot;
+    uint64_t expiresAt;
+
+    // bound to its owner, copies must build their own
+    Timer(const Timer& other);
+    Timer& operator=(const Timer& other);
+  public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    Timer(Targets::Target target, void* owner);
+    ~Timer();
+
+    inline Targets::Target getTarget() const { return this->target; }
+    template <typename T>
+    inline T& getOwner() const { return *static_cast<T*>(this->owner); }
+    inline uint64_t getExpiresAt() const { return this->expiresAt; }
+    inline bool isScheduled() const { return this->slot != Timer::npos; }
+
+    // moves the timer to its new deadline, no-op until it was scheduled once in a wheel
+    void reschedule(uint64_t expiresAt);
+    void cancel();
+  };
+
+  class TimerWheel {
+  private:
+    // ms per slot
+    uint64_t resolution;
+    // one head per slot + the pending (expired) list at the end
+    std::vector<Timer*> slots;
+    uint64_t current;
+  public:
+    TimerWheel(uint64_t resolution, size_t slots);
+    ~TimerWheel();
+
+    void schedule(Timer& timer, uint64_t expiresAt);
+    void cancel(Timer& timer);
+
+    /*
+     * Moves every timer that expired until now to the pending list.
+     * Only slots in between the last call & now are visited.
+     */
+    void advance(uint64_t now);
+    // pops the next expired timer, NULL if there are none left
+    Timer* next();
+  private:
+    TimerWheel(const TimerWheel& other);
+    TimerWheel& operator=(const TimerWheel& other);
+
+    inline size_t pendingSlot() const { return this->slots.size() - 1; }
+    void link(Timer& timer, size_t slot);
+    void unlink(Timer& timer);
+  };
+}
@@ -0,0 +1,152 @@
+/**
+ * WriteQueue.hpp
+ * Outbound queue of a connection, made of buffer segments.
+ * Segments are either owned (a ByteStream swapped in, never copied),
+ * borrowed (memory that outlives the queue, like string literals),
+ * shared (a range of a refcounted buffer, like cached responses),
+ * a range of an open file, which is pushed with sendfile,
+ * or a producer, which generates its segments lazily (see refill).
+ * Pending memory segments are flushed together with a single writev call,
+ * so headers, bodies & chunk framing never need to be concatenated.
+*/
+#pragma once
+
+#include <deque>
+#include <string>
+#include <stdint.h>
+#include <sys/types.h>
+#include <ByteStream.hpp>
+
+namespace Socket {
+  class WriteQueue {
+  public:
+    /*
+     * Generates data on demand, so big bodies never sit in memory as a whole.
+     * produce pushes its next segments into the given queue,
+     * it returns false once there is nothing left to produce.
+     */
+    class Producer {
+    public:
+      virtual ~Producer() {}
+      virtual bool produce(WriteQueue& queue) = 0;
+    };
+
+    /*
+     * Refcounted open fd, shared between a cache & the queues sending it.
+     * Closed once the last reference is released.
+     */
+    class SharedFd {
+    public:
+      SharedFd(int fd);
+
+      inline int get() const { return this->fd; }
+      inline SharedFd* retain() { this->refs++; return this; }
+      void release();
+    private:
+      ~SharedFd();
+      SharedFd(const SharedFd& other);
+      SharedFd& operator=(const SharedFd& other);
+
+      int fd;
+      uint32_t refs;
+    };
+
+    /*
+     * Refcounted immutable bytes, shared between a cache & the queues sending them.
+     * Freed once the last reference is released.
+     */
+    class SharedBuffer {
+    public:
+      SharedBuffer();
+
+      inline ByteStream& get() { return this->data; }
+      inline const ByteStream& get() const { return this->data; }
+      inline SharedBuffer* retain() { this->refs++; return this; }
+      void release();
+    private:
+      ~SharedBuffer();
+      SharedBuffer(const SharedBuffer& other);
+      SharedBuffer& operator=(const SharedBuffer& other);
+
+      ByteStream data;
+      uint32_t refs;
+    };
+  private:
+    struct Segment {
+      // NULL when borrowed or shared
+      ByteStream* owned;
+      // NULL unless shared, released once sent otherwise
+      SharedBuffer* shared;
+      const uint8_t* data;
+      // NULL for memory segments, released once sent otherwise
+      SharedFd* file;
+      // owned, NULL unless it's a producer segment
+      Producer* producer;
+      // where the range starts in the file
+      uint64_t start;
+      uint64_t size;
+      uint64_t offset;
+
+      Segment(ByteStream* owned, const uint8_t* data, uint64_t size)
+        : owned(owned), shared(NULL), data(data), file(NULL), producer(NULL), start(0), size(size), offset(0) {}
+      Segment(SharedBuffer* shared, const uint8_t* data, uint64_t size)
+        : owned(NULL), shared(shared), data(data), file(NULL), producer(NULL), start(0), size(size), offset(0) {}
+      Segment(SharedFd* file, uint64_t start, uint64_t size)
+        : owned(NULL), shared(NULL), data(NULL), file(file), producer(NULL), start(start), size(size), offset(0) {}
+      Segment(Producer* producer)
+        : owned(NULL), shared(NULL), data(NULL), file(NULL), producer(producer), start(0), size(0), offset(0) {}
+      inline uint64_t remaining() const { return this->size - this->offset; }
+      inline bool isFile() const { return this->file != NULL; }
+      inline bool isProducer() const { return this->producer != NULL; }
+    };
+
+    std::deque<Segment> segments;
+    uint64_t bytes;
+
+    WriteQueue(const WriteQueue& other);
+    WriteQueue& operator=(const WriteQueue& other);
+  public:
+    WriteQueue();
+    ~WriteQueue();
+
+    // bytes ready to be sent, what producers will generate isn't known yet
+    inline uint64_t size() const { return this->bytes; }
+    inline bool empty() const { return this->segments.empty(); }
+    inline size_t count() const { return this->segments.size(); }
+
+    // takes the content of data (swapped, data is left empty)
+    void push(ByteStream& data);
+    // copies data into an owned segment
+    void push(const std::string& data);
+    // data must stay alive until it is flushed
+    void borrow(const void* data, uint64_t size);
+    // retains a reference on buffer, size bytes starting at offset are sent
+    void share(SharedBuffer* buffer, uint64_t offset, uint64_t size);
+    // takes ownership of fd, size bytes starting at offset are sent with sendfile
+    void pushFile(int fd, uint64_t offset, uint64_t size);
+    // same, but only retains a reference on the shared fd
+    void pushFile(SharedFd* file, uint64_t offset, uint64_t size);
+    // takes ownership of producer, what it produces is sent after what is queued before it
+    void pushProducer(Producer* producer);
+
+    /*
+     * Runs the first pending producer until at least watermark bytes
+     * are ready in front of it (or it is done).
+     */
+    void refill(uint64_t watermark);
+
+    void consume(uint64_t bytes);
+    void clear();
+
+    /*
+     * Writes up to maxBytes of the pending segments to fd,
+     * with writev for memory segments & sendfile for file ones.
+     * Stops at producers, see refill.
+     * Returns what the syscall returned, written bytes are consumed.
+     */
+    ssize_t flush(int fd, uint64_t maxBytes);
+  private:
+    ssize_t flushFile(int fd, uint64_t maxBytes);
+    void pop();
+  };
+}
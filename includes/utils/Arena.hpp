@@ -0,0 +1,50 @@
+/**
+ * Arena.hpp
+ * Bump allocator for data that dies all at once (i.e. everything of a request).
+ * Allocating only moves a cursor, nothing is freed on its own, reset drops it all in one shot.
+ * Memory is kept across resets: once it grew over several blocks, reset merges them into one
+ * as big as the high-water mark, so a warmed up arena stops calling malloc at all.
+ * Blocks are only allocated on first use, an unused arena costs nothing.
+*/
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace Utils {
+  class Arena {
+  public:
+    Arena(size_t blockSize = 4096);
+    ~Arena();
+    // a copy starts empty, memory is never shared
+    Arena(const Arena& other);
+    Arena& operator=(const Arena& other);
+    void swap(Arena& other);
+
+    void* allocate(size_t size, size_t align = sizeof(void*));
+    // copies size bytes, NUL terminated
+    char* copy(const char* data, size_t size);
+    // everything allocated so far is dropped
+    void reset();
+
+    // bytes handed out since the last reset
+    inline size_t used() const { return this->bytes; }
+    inline size_t capacity() const { return this->total; }
+  private:
+    struct Block {
+      Block* next;
+      size_t size;
+      // data follows
+    };
+    size_t blockSize;
+    // newest first
+    Block* blocks;
+    char* cursor;
+    char* end;
+    size_t bytes;
+    size_t total;
+
+    void grow(size_t size, size_t align);
+    void release();
+  };
+}
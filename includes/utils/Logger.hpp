@@ -69,11 +69,14 @@ namespace Logger {
     ~Stream();
     Stream(const Stream& other);
     Stream& operator=(const Stream& other);
+    // to skip building costly params of disabled logs
+    inline bool isEnabled() const { return this->enabled; }
 
     template <typename T>
     std::ostream& operator<<(const T& value) {
       if (!this->enabled) {
-        this->vstream.clear();
+        // a failed stream discards everything, instead of piling it up
+        this->vstream.setstate(std::ios::badbit);
         return this->vstream;
       };
       return this->target << this->buildHeader() << " " << value;
@@ -48,6 +48,10 @@ namespace Utils
   }
 
   std::string getJSONDate(time_t basetime = -1);
+  // getJSONDate() of the current second, formatted once per second by refreshHTTPDate
+  const std::string& getHTTPDate();
+  // no-op unless the second changed since the last call, the event loop calls it on every tick
+  void refreshHTTPDate();
   void showStackTrace();
 
   bool isWhitespace(const std::string& str);
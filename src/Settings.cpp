@@ -1,10 +1,21 @@
 #include "Settings.hpp"
 #include <utils/Logger.hpp>
 #include <utils/misc.hpp>
+#include <cstdlib>
 
 const char* Settings::path = "bin/.sys/config/settings.yaml";
 
-Settings::Settings() : config() {
+Settings::Snapshot::Snapshot()
+  : runTests(false), workers(1), epollBatch(1), acceptBudget(1), maxConnections(0),
+  keepAliveTimeout(0), maxRequestsPerConnection(0), hasPollTimeout(false), pollTimeout(0),
+  readBufferSize(0), writeBufferSize(0), maxBodySize(0), maxUriSize(0),
+  requestBodyMaxMemory(0), requestBodyTempDir(), statusCodes(), defaultIndex(),
+  directoryBuilderTemplate(), fileChunks(0), fileChunkSize(0), fileCacheMaxEntries(0),
+  fileCacheTtl(0), responseCacheMaxFileSize(0), responseCacheMaxMemory(0), cgiTimeout(0),
+  fastCGIMinWorkers(0), fastCGIMaxWorkers(1), fastCGIIdleTimeout(0),
+  logLevel(3), name(), defaultConfigFile() {}
+
+Settings::Settings() : config(), snapshot(), resolved(false), resolveError() {
   try {
     const_cast<YAML::Node&>(this->config) = YAML::LoadFile(Settings::path);
   }
@@ -13,7 +24,67 @@ Settings::Settings() : config() {
       << "Failed to load settings: "
       << Logger::param(e.what())
       << std::newl;
+    return;
+  }
+  // resolved right away, some of it is read during static initialization (i.e. by the Logger itself),
+  // failures are reported by isValid
+  try {
+    this->resolve();
+  }
+  catch (const std::exception& e) {
+    this->resolveError = e.what();
+  }
+}
+
+void Settings::resolve() {
+  Snapshot& snap = this->snapshot;
+
+  // first, so errors past it are still logged at the right level
+  snap.logLevel = this->get<int>("misc.log_level");
+  snap.name = this->get<std::string>("misc.name");
+  snap.defaultConfigFile = this->get<std::string>("misc.default_config_file");
+
+  snap.runTests = this->get<bool>("yaml.run_tests");
+
+  snap.workers = this->get<int>("socket.workers");
+  snap.epollBatch = this->get<int>("socket.epoll_batch");
+  snap.acceptBudget = this->get<int>("socket.accept_budget");
+  snap.maxConnections = this->get<int>("socket.max_connections");
+  snap.keepAliveTimeout = this->get<int>("socket.keep_alive_timeout");
+  snap.maxRequestsPerConnection = this->get<uint32_t>("socket.max_requests_per_connection");
+  snap.hasPollTimeout = this->config["socket"].has("poll_timeout");
+  if (snap.hasPollTimeout)
+    snap.pollTimeout = this->get<int>("socket.poll_timeout");
+  snap.readBufferSize = this->get<uint64_t>("socket.read_buffer_size");
+  snap.writeBufferSize = this->get<uint64_t>("socket.write_buffer_size");
+
+  snap.maxBodySize = this->get<uint32_t>("http.max_body_size");
+  snap.maxUriSize = this->get<size_t>("http.max_uri_size");
+  snap.requestBodyMaxMemory = this->get<uint64_t>("http.request_body.max_memory");
+  snap.requestBodyTempDir = this->get<std::string>("http.request_body.temp_dir");
+  const YAML::Node& codes = this->config["http"]["status_codes"];
+  for (
+    YAML::Node::map_const_iterator it = codes.begin<YAML::Node::Map>();
+    it != codes.end<YAML::Node::Map>();
+    ++it
+    ) {
+    if (!Utils::isInteger(it->first, true))
+      throw std::runtime_error("Invalid status code: " + it->first);
+    snap.statusCodes[std::atoi(it->first.c_str())] = it->second.getValue();
   }
+  snap.defaultIndex = this->get<std::string>("http.static.default_index");
+  snap.directoryBuilderTemplate = this->get<std::string>("http.static.directory_builder_template");
+  snap.fileChunks = this->get<uint64_t>("http.static.file_chunks");
+  snap.fileChunkSize = this->get<uint64_t>("http.static.file_chunk_size");
+  snap.fileCacheMaxEntries = this->get<uint64_t>("http.static.file_cache.max_entries");
+  snap.fileCacheTtl = this->get<uint64_t>("http.static.file_cache.ttl");
+  snap.responseCacheMaxFileSize = this->get<uint64_t>("http.static.response_cache.max_file_size");
+  snap.responseCacheMaxMemory = this->get<uint64_t>("http.static.response_cache.max_memory");
+  snap.cgiTimeout = this->get<int>("http.cgi.timeout");
+  snap.fastCGIMinWorkers = this->get<int>("http.cgi.fastcgi.min_workers");
+  snap.fastCGIMaxWorkers = this->get<int>("http.cgi.fastcgi.max_workers");
+  snap.fastCGIIdleTimeout = this->get<int>("http.cgi.fastcgi.idle_timeout");
+  this->resolved = true;
 }
 
 bool Settings::isValid() const {
@@ -30,10 +101,18 @@ bool Settings::isValid() const {
     // * Socket *
     if (!this->config["socket"].is<YAML::Types::Map>())
       throw std::runtime_error("socket isn't a map");
+    if (!this->config["socket"]["workers"].is<int>() || this->config["socket"]["workers"].as<int>() < 1)
+      throw std::runtime_error("workers isn't a positive integer");
+    if (!this->config["socket"]["epoll_batch"].is<int>() || this->config["socket"]["epoll_batch"].as<int>() < 1)
+      throw std::runtime_error("epoll_batch isn't a positive integer");
+    if (!this->config["socket"]["accept_budget"].is<int>() || this->config["socket"]["accept_budget"].as<int>() < 1)
+      throw std::runtime_error("accept_budget isn't a positive integer");
     if (!this->config["socket"]["max_connections"].is<int>())
       throw std::runtime_error("max_connections isn't an integer");
     if (!this->config["socket"]["keep_alive_timeout"].is<int>())
       throw std::runtime_error("keep_alive_timeout isn't an integer");
+    if (!this->config["socket"]["max_requests_per_connection"].is<int>() || this->config["socket"]["max_requests_per_connection"].as<int>() < 0)
+      throw std::runtime_error("max_requests_per_connection isn't a non-negative integer");
     if (!this->config["socket"]["read_buffer_size"].is<int>())
       throw std::runtime_error("read_buffer_size isn't an integer");
     if (!this->config["socket"]["write_buffer_size"].is<int>())
@@ -42,8 +121,16 @@ bool Settings::isValid() const {
       throw std::runtime_error("http isn't a map");
     if (!this->config["http"]["max_body_size"].is<int>())
       throw std::runtime_error("max_body_size isn't an integer");
+    if (!this->config["http"]["request_body"].is<YAML::Types::Map>())
+      throw std::runtime_error("request_body isn't a map");
+    if (!this->config["http"]["request_body"]["max_memory"].is<int>() || this->config["http"]["request_body"]["max_memory"].as<int>() < 0)
+      throw std::runtime_error("request_body max_memory isn't a non-negative integer");
+    if (!this->config["http"]["request_body"]["temp_dir"].is<std::string>() || this->config["http"]["request_body"]["temp_dir"].getValue().empty())
+      throw std::runtime_error("request_body temp_dir isn't a path");
     if (!this->config["http"]["max_uri_size"].is<int>())
       throw std::runtime_error("max_uri_size isn't an integer");
+    if (!this->config["http"]["error_pages"].is<YAML::Types::Map>())
+      throw std::runtime_error("error_pages isn't a map");
     if (!this->config["http"]["status_codes"].is<YAML::Types::Map>())
       throw std::runtime_error("status_codes isn't a map");
     if (!this->config["http"]["mime_types"].is<YAML::Types::Map>())
@@ -54,16 +141,41 @@ bool Settings::isValid() const {
       throw std::runtime_error("mime_types must have __default__ scalar");
     if (!this->config["http"]["static"].is<YAML::Types::Map>())
       throw std::runtime_error("static isn't a map");
+    if (!this->config["http"]["static"]["default_index"].is<std::string>())
+      throw std::runtime_error("default_index isn't a string");
     if (!this->config["http"]["static"]["directory_builder_template"].is<std::string>())
       throw std::runtime_error("directory_builder_template isn't a string");
     if (!this->config["http"]["static"]["file_chunks"].is<int>())
       throw std::runtime_error("file_chunks isn't an integer");
     if (!this->config["http"]["static"]["file_chunk_size"].is<int>())
       throw std::runtime_error("file_chunk_size isn't an integer");
+    if (!this->config["http"]["static"]["file_cache"].is<YAML::Types::Map>())
+      throw std::runtime_error("file_cache isn't a map");
+    if (!this->config["http"]["static"]["file_cache"]["max_entries"].is<int>() || this->config["http"]["static"]["file_cache"]["max_entries"].as<int>() < 0)
+      throw std::runtime_error("file_cache max_entries isn't a non-negative integer");
+    if (!this->config["http"]["static"]["file_cache"]["ttl"].is<int>() || this->config["http"]["static"]["file_cache"]["ttl"].as<int>() < 0)
+      throw std::runtime_error("file_cache ttl isn't a non-negative integer");
+    if (!this->config["http"]["static"]["response_cache"].is<YAML::Types::Map>())
+      throw std::runtime_error("response_cache isn't a map");
+    if (!this->config["http"]["static"]["response_cache"]["max_file_size"].is<int>() || this->config["http"]["static"]["response_cache"]["max_file_size"].as<int>() < 0)
+      throw std::runtime_error("response_cache max_file_size isn't a non-negative integer");
+    if (!this->config["http"]["static"]["response_cache"]["max_memory"].is<int>() || this->config["http"]["static"]["response_cache"]["max_memory"].as<int>() < 0)
+      throw std::runtime_error("response_cache max_memory isn't a non-negative integer");
     if (!this->config["http"]["cgi"].is<YAML::Types::Map>())
       throw std::runtime_error("cgi isn't a map");
     if (!this->config["http"]["cgi"]["timeout"].is<int>())
       throw std::runtime_error("cgi timeout isn't an integer");
+    const YAML::Node& fastcgi = this->config["http"]["cgi"]["fastcgi"];
+    if (!fastcgi.is<YAML::Types::Map>())
+      throw std::runtime_error("cgi fastcgi isn't a map");
+    if (!fastcgi["min_workers"].is<int>() || fastcgi["min_workers"].as<int>() < 0)
+      throw std::runtime_error("fastcgi min_workers isn't a non-negative integer");
+    if (!fastcgi["max_workers"].is<int>() || fastcgi["max_workers"].as<int>() < 1)
+      throw std::runtime_error("fastcgi max_workers isn't a positive integer");
+    if (fastcgi["min_workers"].as<int>() > fastcgi["max_workers"].as<int>())
+      throw std::runtime_error("fastcgi min_workers is bigger than max_workers");
+    if (!fastcgi["idle_timeout"].is<int>() || fastcgi["idle_timeout"].as<int>() < 0)
+      throw std::runtime_error("fastcgi idle_timeout isn't a non-negative integer");
     if (!this->config["misc"].is<YAML::Types::Map>())
       throw std::runtime_error("misc isn't a map");
     if (!this->config["misc"]["log_level"].is<int>())
@@ -72,6 +184,9 @@ bool Settings::isValid() const {
       throw std::runtime_error("name isn't a string");
     if (!this->config["misc"]["default_config_file"].is<std::string>())
       throw std::runtime_error("default_config_file isn't a string");
+    // every check passed but a value still couldn't be read into the snapshot
+    if (!this->resolved)
+      throw std::runtime_error("settings couldn't be resolved: " + this->resolveError);
     return true;
   }
   catch (const std::exception& e) {
@@ -83,12 +198,12 @@ bool Settings::isValid() const {
   }
 }
 
-const std::string Settings::httpStatusCode(int code) const {
-  static const YAML::Node& codes = this->config["http"]["status_codes"];
-  const std::string codeStr = Utils::toString(code);
-  if (!codes.has(codeStr))
-    return "";
-  return codes[codeStr].getValue();
+const std::string& Settings::httpStatusCode(int code) const {
+  static const std::string unknown;
+  const std::map<int, std::string>::const_iterator it = this->snapshot.statusCodes.find(code);
+  if (it == this->snapshot.statusCodes.end())
+    return unknown;
+  return it->second;
 }
 
 const std::string& Settings::httpMimeType(const std::string& ext) const {
@@ -114,7 +114,7 @@ static bool test(const std::string& path, void (*handler)(const YAML::Node& node
 
 void YAML::RunTests() {
   const Settings* settings = Instance::Get<Settings>();
-  if (!settings->get<bool>("yaml.run_tests"))
+  if (!settings->getSnapshot().runTests)
     return;
   (void)maps;
   (void)sequences;
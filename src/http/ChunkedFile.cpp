@@ -0,0 +1,35 @@
+#include "http/ChunkedFile.hpp"
+#include <shared.hpp>
+#include <utils/Logger.hpp>
+#include <sstream>
+
+using HTTP::ChunkedFile;
+
+ChunkedFile::ChunkedFile(const std::string& path, uint64_t chunkSize)
+  : file(path.c_str(), std::ios::binary), chunkSize(chunkSize) {}
+
+ChunkedFile::~ChunkedFile() {
+  if (this->file.is_open())
+    this->file.close();
+}
+
+bool ChunkedFile::produce(Socket::WriteQueue& queue) {
+  // read straight into the chunk, which is then handed over to the write queue
+  ByteStream chunk(this->chunkSize);
+  this->file.read(reinterpret_cast<char*>(chunk.data()), this->chunkSize);
+  chunk.resize(this->file.gcount());
+  // framing & data are queued as separate segments
+  if (chunk.size() > 0) {
+    Logger::debug
+      << "Sending chunk of size: " << Logger::param(chunk.size()) << std::newl;
+    std::stringstream chunkBytes;
+    chunkBytes << std::hex << chunk.size() << "\r\n";
+    queue.push(chunkBytes.str());
+    queue.push(chunk);
+    queue.borrow("\r\n", 2);
+  }
+  if (this->file)
+    return true;
+  queue.borrow("0\r\n\r\n", 5);
+  return false;
+}
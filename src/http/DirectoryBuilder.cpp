@@ -111,7 +111,7 @@ DirectoryBuilder::Entry::operator std::string() const {
 }
 
 DirectoryBuilder::DirectoryBuilder() {
-  this->loadTemplate(Instance::Get<Settings>()->get<std::string>("http.static.directory_builder_template"));
+  this->loadTemplate(Instance::Get<Settings>()->getSnapshot().directoryBuilderTemplate);
 }
 
 void DirectoryBuilder::loadTemplate(const std::string& path) {
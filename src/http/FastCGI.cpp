@@ -0,0 +1,472 @@
+#include "http/FastCGI.hpp"
+#include "http/ServerManager.hpp"
+#include <Settings.hpp>
+#include <utils/misc.hpp>
+#include <utils/Logger.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <csignal>
+#include <algorithm>
+
+using namespace HTTP::FastCGI;
+
+static Settings* settings = Instance::Get<Settings>();
+
+static const uint8_t version = 1;
+static const size_t headerSize = 8;
+static const uint16_t responderRole = 1;
+static const uint8_t keepConnection = 1;
+// biggest content of a record that needs no padding
+static const size_t maxChunk = 65528;
+static const int readEvents = EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR;
+
+static inline void append(ByteStream& out, const uint8_t* data, size_t size) {
+  if (size == 0)
+    return;
+  const uint64_t offset = out.size();
+  out.resize(offset + size);
+  std::memcpy(out.data() + offset, data, size);
+}
+
+void HTTP::FastCGI::PutRecord(ByteStream& out, RecordTypes::Type type, uint16_t requestId, const uint8_t* data, size_t size) {
+  const uint8_t padding = (8 - size % 8) % 8;
+  const uint8_t header[headerSize] = {
+    version, static_cast<uint8_t>(type),
+    static_cast<uint8_t>(requestId >> 8), static_cast<uint8_t>(requestId & 0xff),
+    static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size & 0xff),
+    padding, 0
+  };
+  static const uint8_t zeros[8] = { 0 };
+  append(out, header, headerSize);
+  append(out, data, size);
+  append(out, zeros, padding);
+}
+
+void HTTP::FastCGI::PutStream(ByteStream& out, RecordTypes::Type type, uint16_t requestId, const uint8_t* data, size_t size) {
+  for (size_t offset = 0; offset < size; offset += maxChunk)
+    PutRecord(out, type, requestId, data + offset, std::min(maxChunk, size - offset));
+}
+
+static void putLength(ByteStream& out, size_t size) {
+  if (size < 128) {
+    out.put(static_cast<uint8_t>(size));
+    return;
+  }
+  out.put(static_cast<uint8_t>((size >> 24) | 0x80));
+  out.put(static_cast<uint8_t>((size >> 16) & 0xff));
+  out.put(static_cast<uint8_t>((size >> 8) & 0xff));
+  out.put(static_cast<uint8_t>(size & 0xff));
+}
+
+void HTTP::FastCGI::PutParam(ByteStream& out, const std::string& name, const std::string& value) {
+  putLength(out, name.size());
+  putLength(out, value.size());
+  append(out, reinterpret_cast<const uint8_t*>(name.data()), name.size());
+  append(out, reinterpret_cast<const uint8_t*>(value.data()), value.size());
+}
+
+/* Job */
+
+Job::Job(Pool& pool, Response& res, ByteStream& params, int bodyFd)
+  : pool(pool), pending(NULL), params(), body(), bodyFd(bodyFd), worker(NULL) {
+  this->params.swap(params);
+  // spilled bodies are streamed from their file instead
+  const RequestBody& body = res.getRequest().getBody();
+  if (!body.isFile())
+    this->body = body.getData();
+  const_cast<RequestBody&>(body).clear();
+  this->pending = new PendingResponse(res.getRequest(), res.getRoute());
+}
+
+Job::~Job() {
+  if (this->bodyFd >= 0)
+    close(this->bodyFd);
+  delete this->pending;
+}
+
+/* Worker */
+
+Worker::Worker(Pool& pool, pid_t pid, int fd)
+  : pool(pool), pid(pid), fd(fd), state(States::Idle), job(NULL), requestId(0),
+  readBuffer(), writeBuffer(), writing(false), timer(Socket::Timer::Targets::Upstream, this) {}
+
+Worker::~Worker() {}
+
+void Worker::start(Job* job) {
+  // 0 is reserved for management records
+  this->requestId = this->requestId % 0xffff + 1;
+  const uint8_t begin[8] = {
+    static_cast<uint8_t>(responderRole >> 8), static_cast<uint8_t>(responderRole & 0xff),
+    keepConnection, 0, 0, 0, 0, 0
+  };
+  PutRecord(this->writeBuffer, RecordTypes::BeginRequest, this->requestId, begin, sizeof(begin));
+  PutStream(this->writeBuffer, RecordTypes::Params, this->requestId, job->params.data(), job->params.size());
+  PutRecord(this->writeBuffer, RecordTypes::Params, this->requestId, NULL, 0);
+  if (job->bodyFd < 0) {
+    PutStream(this->writeBuffer, RecordTypes::Stdin, this->requestId, job->body.data(), job->body.size());
+    PutRecord(this->writeBuffer, RecordTypes::Stdin, this->requestId, NULL, 0);
+  }
+  job->params.clear();
+  job->body.clear();
+  job->worker = this;
+  this->job = job;
+  this->state = States::Busy;
+  this->pool.loop.schedule(this->timer, Utils::getCurrentTime() + settings->getSnapshot().cgiTimeout);
+  Logger::debug
+    << "FastCGI worker " << Logger::param(this->pid)
+    << " started request " << Logger::param(this->requestId) << std::newl;
+  this->write();
+}
+
+void Worker::abort() {
+  Job* job = this->job;
+  this->job = NULL;
+  job->worker = NULL;
+  // stopping midway through the request would leave the stream broken
+  if (job->bodyFd >= 0 || !this->writeBuffer.empty())
+    return this->pool.onWorkerExit(*this, ExitCodes::Force);
+  PutRecord(this->writeBuffer, RecordTypes::AbortRequest, this->requestId, NULL, 0);
+  this->state = States::Draining;
+  this->write();
+}
+
+void Worker::onEvent(const Socket::File& file) {
+  if (file.isErrored())
+    return this->pool.onWorkerExit(*this, ExitCodes::Force);
+  if (file.isWritable() && !this->write())
+    return;
+  // a hang up is read as EOF
+  if (file.isReadable() || file.isClosed())
+    this->read();
+}
+
+void Worker::onTimeout() {
+  if (this->state == States::Idle) {
+    // idle timers of several workers may expire together, the pool keeps its min
+    if (this->pool.workers.size() <= this->pool.minWorkers)
+      return;
+    Logger::debug
+      << "Retiring idle FastCGI worker " << Logger::param(this->pid) << std::newl;
+    return this->pool.retire(*this);
+  }
+  Logger::warning
+    << "FastCGI worker " << Logger::param(this->pid)
+    << " timed out on request " << Logger::param(this->requestId) << std::newl;
+  this->pool.onWorkerExit(*this, ExitCodes::Timeout);
+}
+
+bool Worker::feedBody(bool& failed) {
+  if (!this->job || this->job->bodyFd < 0)
+    return false;
+  uint8_t buffer[maxChunk];
+  ssize_t bytes;
+  do
+    bytes = ::read(this->job->bodyFd, buffer, sizeof(buffer));
+  while (bytes < 0 && errno == EINTR);
+  if (bytes < 0) {
+    // CONTENT_LENGTH promised the whole body, a truncated one must not reach the script
+    Logger::error
+      << "Failed to read the request body for FastCGI worker " << Logger::param(this->pid)
+      << ": " << Logger::errstr() << std::newl;
+    failed = true;
+    return false;
+  }
+  if (bytes > 0) {
+    PutRecord(this->writeBuffer, RecordTypes::Stdin, this->requestId, buffer, bytes);
+    return true;
+  }
+  close(this->job->bodyFd);
+  this->job->bodyFd = -1;
+  PutRecord(this->writeBuffer, RecordTypes::Stdin, this->requestId, NULL, 0);
+  return true;
+}
+
+bool Worker::write() {
+  bool failed = false;
+  while (!this->writeBuffer.empty() || this->feedBody(failed)) {
+    const ssize_t bytes = ::send(this->fd, this->writeBuffer.data(), this->writeBuffer.size(), MSG_NOSIGNAL);
+    if (bytes < 0) {
+      // anything else breaks the socket, its next event says so
+      this->setWriting(errno == EAGAIN || errno == EWOULDBLOCK);
+      return true;
+    }
+    this->writeBuffer.ignore(bytes);
+  }
+  if (failed) {
+    this->pool.onWorkerExit(*this, ExitCodes::Force);
+    return false;
+  }
+  this->setWriting(false);
+  return true;
+}
+
+void Worker::setWriting(bool state) {
+  if (state == this->writing)
+    return;
+  this->writing = state;
+  this->pool.loop.updateUpstream(this->fd, state ? readEvents | EPOLLOUT : readEvents);
+}
+
+void Worker::read() {
+  const uint64_t bufferSize = settings->getSnapshot().readBufferSize;
+  const uint64_t lastSize = this->readBuffer.size();
+  this->readBuffer.resize(lastSize + bufferSize);
+  const ssize_t bytes = ::recv(this->fd, this->readBuffer.data() + lastSize, bufferSize, 0);
+  if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    this->readBuffer.resize(lastSize);
+    return;
+  }
+  if (bytes <= 0) {
+    this->readBuffer.resize(lastSize);
+    Logger::warning
+      << "FastCGI worker " << Logger::param(this->pid) << " closed its connection" << std::newl;
+    return this->pool.onWorkerExit(*this, ExitCodes::Force);
+  }
+  this->readBuffer.resize(lastSize + bytes);
+  if (this->job)
+    this->job->getClient().ping();
+  while (this->readBuffer.size() >= headerSize) {
+    const uint8_t* header = this->readBuffer.data();
+    if (header[0] != version) {
+      Logger::error
+        << "FastCGI worker " << Logger::param(this->pid)
+        << " sent a record of version " << Logger::param(static_cast<int>(header[0])) << std::newl;
+      return this->pool.onWorkerExit(*this, ExitCodes::Force);
+    }
+    const uint16_t id = (header[2] << 8) | header[3];
+    const size_t contentSize = (header[4] << 8) | header[5];
+    const size_t recordSize = headerSize + contentSize + header[6];
+    if (this->readBuffer.size() < recordSize)
+      break;
+    const uint8_t* content = header + headerSize;
+    // records of an aborted request are dropped
+    const bool current = id == this->requestId && this->state != States::Idle;
+    bool ended = false;
+    switch (header[1]) {
+      case RecordTypes::Stdout:
+        if (current && this->job)
+          append(this->job->getPending().response.getRawBody(), content, contentSize);
+        break;
+      case RecordTypes::Stderr:
+        if (contentSize > 0)
+          Logger::warning
+            << "FastCGI worker " << Logger::param(this->pid) << ": "
+            << std::string(reinterpret_cast<const char*>(content), contentSize) << std::newl;
+        break;
+      case RecordTypes::EndRequest:
+        ended = current;
+        break;
+      default:
+        break;
+    }
+    this->readBuffer.ignore(recordSize);
+    // handing the job back may start another one on this worker, or retire it
+    if (ended)
+      return this->pool.onWorkerDone(*this);
+  }
+}
+
+/* Pool */
+
+Pool::Pool(WebSocket& loop, const std::string& path, const std::vector<std::string>& args, int minWorkers, int maxWorkers)
+  : loop(loop), path(path), args(args), minWorkers(minWorkers), maxWorkers(maxWorkers),
+  workers(), queue(), owner(-1), spawned(0) {}
+
+Pool::~Pool() {
+  while (!this->workers.empty()) {
+    Worker* worker = this->workers.back();
+    if (worker->job)
+      delete worker->job;
+    this->retire(*worker);
+  }
+  for (size_t i = 0; i < this->queue.size(); i++)
+    delete this->queue[i];
+}
+
+void Pool::start() {
+  this->owner = getpid();
+  for (size_t i = 0; i < this->minWorkers; i++)
+    if (!this->spawn())
+      break;
+}
+
+Worker* Pool::spawn() {
+  std::string execPath = this->path;
+  if (execPath[0] != '/')
+    execPath = Utils::resolvePath(2, Utils::getCurrentWorkingDirectory().c_str(), execPath.c_str());
+  if (access(execPath.c_str(), F_OK | X_OK) == -1) {
+    Logger::error
+      << "Attempted to spawn a FastCGI worker that doesn't exist: " << Logger::param(execPath) << std::newl;
+    return NULL;
+  }
+  if (this->owner == -1)
+    this->owner = getpid();
+  // abstract namespace, nothing to clean up on the filesystem
+  const std::string name = "webserv-fastcgi-" + Utils::toString(getpid()) + "-" + Utils::toString(this->spawned++);
+  struct sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path + 1, name.data(), std::min(name.size(), sizeof(address.sun_path) - 1));
+  const socklen_t addressSize = offsetof(struct sockaddr_un, sun_path) + 1 + name.size();
+
+  const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listener < 0) {
+    Logger::error
+      << "Failed to create a socket for a FastCGI worker: " << Logger::errstr() << std::newl;
+    return NULL;
+  }
+  int fd = -1;
+  if (
+    ::bind(listener, reinterpret_cast<struct sockaddr*>(&address), addressSize) < 0 ||
+    ::listen(listener, 1) < 0 ||
+    (fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0 ||
+    // queued in the backlog, accepted by the worker once it's up
+    ::connect(fd, reinterpret_cast<struct sockaddr*>(&address), addressSize) < 0
+    ) {
+    Logger::error
+      << "Failed to set up the socket of a FastCGI worker: " << Logger::errstr() << std::newl;
+    close(listener);
+    if (fd >= 0)
+      close(fd);
+    return NULL;
+  }
+  const pid_t pid = fork();
+  if (pid == -1) {
+    Logger::error
+      << "Failed to fork a FastCGI worker: " << Logger::errstr() << std::newl;
+    close(listener);
+    close(fd);
+    return NULL;
+  }
+  if (pid == 0) {
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGPIPE, SIG_DFL);
+    // don't outlive the server, even if it's killed without a chance to clean up
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    // FCGI_LISTENSOCK_FILENO
+    if (dup2(listener, STDIN_FILENO) < 0)
+      _exit(1);
+    std::vector<char*> args(this->args.size() + 2, static_cast<char*>(NULL));
+    args[0] = const_cast<char*>(this->path.c_str());
+    for (size_t i = 0; i < this->args.size(); i++)
+      args[i + 1] = const_cast<char*>(this->args[i].c_str());
+    execve(execPath.c_str(), args.data(), const_cast<char* const*>(Instance::Get<ServerManager>()->getEnv()));
+    std::perror("execve");
+    // no destructors, they would tear down the server's state
+    _exit(1);
+  }
+  close(listener);
+  Worker* worker = new Worker(*this, pid, fd);
+  if (!this->loop.trackUpstream(fd, readEvents, worker)) {
+    Logger::error
+      << "Failed to track the socket of FastCGI worker " << Logger::param(pid) << std::newl;
+    close(fd);
+    ::kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    delete worker;
+    return NULL;
+  }
+  this->workers.push_back(worker);
+  Logger::info
+    << "Spawned FastCGI worker " << Logger::param(pid)
+    << " (" << Logger::param(this->workers.size()) << "/" << Logger::param(this->maxWorkers) << ")"
+    << " for " << Logger::param(this->path) << std::newl;
+  return worker;
+}
+
+bool Pool::submit(Job* job) {
+  if (this->workers.empty() && !this->spawn())
+    return false;
+  this->queue.push_back(job);
+  this->dispatch();
+  return true;
+}
+
+void Pool::cancel(Job* job) {
+  if (job->worker)
+    job->worker->abort();
+  else {
+    std::deque<Job*>::iterator it = std::find(this->queue.begin(), this->queue.end(), job);
+    if (it != this->queue.end())
+      this->queue.erase(it);
+  }
+  this->onJobDone(job, ExitCodes::ClientTimeout);
+}
+
+void Pool::dispatch() {
+  while (!this->queue.empty()) {
+    Worker* worker = NULL;
+    for (size_t i = 0; i < this->workers.size() && !worker; i++)
+      if (this->workers[i]->state == Worker::States::Idle)
+        worker = this->workers[i];
+    if (!worker && this->workers.size() < this->maxWorkers)
+      worker = this->spawn();
+    if (!worker)
+      break;
+    Job* job = this->queue.front();
+    this->queue.pop_front();
+    worker->start(job);
+  }
+  // every worker died & none could be replaced
+  if (!this->queue.empty() && this->workers.empty()) {
+    std::deque<Job*> failed;
+    failed.swap(this->queue);
+    for (size_t i = 0; i < failed.size(); i++)
+      this->onJobDone(failed[i], ExitCodes::Force);
+  }
+  const uint64_t idleTimeout = settings->getSnapshot().fastCGIIdleTimeout;
+  for (size_t i = 0; i < this->workers.size(); i++) {
+    Worker& worker = *this->workers[i];
+    if (worker.state != Worker::States::Idle)
+      continue;
+    if (this->workers.size() <= this->minWorkers)
+      worker.timer.cancel();
+    else if (!worker.timer.isScheduled())
+      this->loop.schedule(worker.timer, Utils::getCurrentTime() + idleTimeout);
+  }
+}
+
+void Pool::onJobDone(Job* job, ExitCodes::Code code) {
+  job->worker = NULL;
+  this->loop.onFastCGIExit(*job, code);
+  delete job;
+}
+
+void Pool::onWorkerDone(Worker& worker) {
+  Job* job = worker.job;
+  worker.job = NULL;
+  worker.state = Worker::States::Idle;
+  worker.timer.cancel();
+  if (job)
+    this->onJobDone(job, ExitCodes::Normal);
+  // the worker may be gone by now
+  this->dispatch();
+}
+
+void Pool::onWorkerExit(Worker& worker, ExitCodes::Code code) {
+  Job* job = worker.job;
+  worker.job = NULL;
+  this->retire(worker);
+  if (job)
+    this->onJobDone(job, code);
+  this->dispatch();
+}
+
+void Pool::retire(Worker& worker) {
+  std::vector<Worker*>::iterator it = std::find(this->workers.begin(), this->workers.end(), &worker);
+  if (it != this->workers.end())
+    this->workers.erase(it);
+  worker.timer.cancel();
+  if (getpid() == this->owner) {
+    this->loop.untrackUpstream(worker.fd);
+    // idle or stuck, either way there's nothing to wait for
+    ::kill(worker.pid, SIGKILL);
+    waitpid(worker.pid, NULL, 0);
+  }
+  delete &worker;
+}
@@ -0,0 +1,104 @@
+#include "http/FileCache.hpp"
+#include <utils/misc.hpp>
+#include <utils/Logger.hpp>
+#include <Settings.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+
+using HTTP::FileCache;
+
+static Settings* settings = Instance::Get<Settings>();
+
+FileCache::FileCache()
+  : lru(), entries(),
+  maxEntries(settings->getSnapshot().fileCacheMaxEntries),
+  ttl(settings->getSnapshot().fileCacheTtl) {
+  // disabled, keep the last file only & check it every time
+  if (this->maxEntries == 0) {
+    this->maxEntries = 1;
+    this->ttl = 0;
+  }
+}
+
+FileCache::~FileCache() {
+  this->clear();
+}
+
+const FileCache::Entry* FileCache::get(const std::string& path) {
+  const uint64_t now = Utils::getCurrentTime();
+  std::map<std::string, List::iterator>::iterator it = this->entries.find(path);
+  if (it != this->entries.end()) {
+    Entry& entry = **it->second;
+    if (this->ttl > 0 && now - entry.validatedAt < this->ttl) {
+      this->lru.splice(this->lru.begin(), this->lru, it->second);
+      return &entry;
+    }
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && !this->isStale(entry, st)) {
+      entry.validatedAt = now;
+      this->lru.splice(this->lru.begin(), this->lru, it->second);
+      return &entry;
+    }
+    this->evict(it->second);
+  }
+  Entry* entry = this->load(path);
+  if (!entry)
+    return NULL;
+  entry->validatedAt = now;
+  while (this->entries.size() >= this->maxEntries)
+    this->evict(--this->lru.end());
+  this->lru.push_front(entry);
+  this->entries.insert(std::make_pair(path, this->lru.begin()));
+  return entry;
+}
+
+void FileCache::invalidate(const std::string& path) {
+  std::map<std::string, List::iterator>::iterator it = this->entries.find(path);
+  if (it != this->entries.end())
+    this->evict(it->second);
+}
+
+void FileCache::clear() {
+  while (!this->lru.empty())
+    this->evict(this->lru.begin());
+}
+
+FileCache::Entry* FileCache::load(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return NULL;
+  }
+  Entry* entry = new Entry();
+  entry->path = path;
+  entry->file = new Socket::WriteQueue::SharedFd(fd);
+  entry->st = st;
+  entry->etag = Utils::httpETag(path, st.st_mtime, st.st_size);
+  entry->lastModified = Utils::getJSONDate(st.st_mtime);
+  entry->mimeType = settings->httpMimeType(Utils::getExtension(path));
+  Logger::debug
+    << "Cached file " << Logger::param(path)
+    << " with fd " << Logger::param(fd) << std::newl;
+  return entry;
+}
+
+bool FileCache::isStale(const Entry& entry, const struct stat& st) const {
+  return entry.st.st_ino != st.st_ino
+    || entry.st.st_dev != st.st_dev
+    || entry.st.st_mtime != st.st_mtime
+    || entry.st.st_mtim.tv_nsec != st.st_mtim.tv_nsec
+    || entry.st.st_size != st.st_size
+    || !S_ISREG(st.st_mode);
+}
+
+void FileCache::evict(List::iterator it) {
+  Entry* entry = *it;
+  this->entries.erase(entry->path);
+  this->lru.erase(it);
+  // write queues still sending it keep the fd open
+  entry->file->release();
+  delete entry;
+}
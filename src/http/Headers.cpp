@@ -1,8 +1,102 @@
 #include <utils/Logger.hpp>
 #include "http/Headers.hpp"
+#include <cctype>
 
 using HTTP::Headers;
 
+// room for a typical request without growing
+static const size_t initialCapacity = 16;
+
+static inline bool isSpace(char c) {
+  return std::isspace(static_cast<unsigned char>(c));
+}
+
+static inline void trim(const char*& str, size_t& size) {
+  while (size > 0 && isSpace(*str)) {
+    str++;
+    size--;
+  }
+  while (size > 0 && isSpace(str[size - 1]))
+    size--;
+}
+
+static const char* const names[] = {
+  "host",
+  "connection",
+  "keep-alive",
+  "content-length",
+  "content-type",
+  "transfer-encoding",
+  "expect",
+  "if-none-match",
+  "if-modified-since",
+  "date",
+  "server",
+  "location",
+  "last-modified",
+  "etag",
+};
+
+static inline bool equals(const char* lowercase, const char* str, size_t size) {
+  size_t i = 0;
+  while (i < size && lowercase[i] == std::tolower(static_cast<unsigned char>(str[i])))
+    i++;
+  return i == size;
+}
+
+static const uint32_t* NameHashes() {
+  static uint32_t hashes[Headers::Names::Unknown];
+  static bool hashed = false;
+  if (!hashed) {
+    for (int i = 0; i < Headers::Names::Unknown; ++i)
+      hashes[i] = Headers::Hash(names[i], std::strlen(names[i]));
+    hashed = true;
+  }
+  return hashes;
+}
+
+static Headers::Names::Name FromHash(uint32_t hash, const char* str, size_t size) {
+  const uint32_t* hashes = NameHashes();
+  for (int i = 0; i < Headers::Names::Unknown; ++i)
+    if (hashes[i] == hash && std::strlen(names[i]) == size && equals(names[i], str, size))
+      return static_cast<Headers::Names::Name>(i);
+  return Headers::Names::Unknown;
+}
+
+Headers::Names::Name Headers::Names::FromString(const char* str, size_t size) {
+  return FromHash(Headers::Hash(str, size), str, size);
+}
+
+const char* Headers::Names::ToString(Name name) {
+  return name < Unknown ? names[name] : "";
+}
+
+uint32_t Headers::Hash(const char* str, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(str[i])));
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+bool Headers::ParseNumber(const char* str, size_t size, uint64_t& value) {
+  static const uint64_t max = static_cast<uint64_t>(-1);
+  if (size == 0)
+    return false;
+  uint64_t result = 0;
+  for (size_t i = 0; i < size; ++i) {
+    if (str[i] < '0' || str[i] > '9')
+      return false;
+    const uint64_t digit = str[i] - '0';
+    if (result > (max - digit) / 10)
+      return false;
+    result = result * 10 + digit;
+  }
+  value = result;
+  return true;
+}
+
 std::string Headers::FormatKey(const std::string& key) {
   std::string formatted = key;
   Utils::toLowercase(formatted);
@@ -16,50 +110,201 @@ std::string Headers::FormatValue(const std::string& value) {
   return formatted;
 }
 
-Headers::Headers() : headers() {}
+Headers::Headers()
+  : memory(1024), arena(&this->memory), entries(NULL), count(0), capacity(0) {
+  std::fill(this->index, this->index + Names::Unknown, 0);
+}
+
+Headers::Headers(Utils::Arena& arena)
+  : memory(1024), arena(&arena), entries(NULL), count(0), capacity(0) {
+  std::fill(this->index, this->index + Names::Unknown, 0);
+}
+
 Headers::~Headers() {}
-Headers::Headers(const Headers& other) : headers(other.headers), keys(other.keys) {}
+
+Headers::Headers(const Headers& other)
+  : memory(1024), arena(&this->memory), entries(NULL), count(0), capacity(0) {
+  std::fill(this->index, this->index + Names::Unknown, 0);
+  *this = other;
+}
+
 Headers& Headers::operator=(const Headers& other) {
   if (this == &other) return *this;
-  this->headers = other.headers;
-  this->keys = other.keys;
+  this->clear();
+  for (size_t i = 0; i < other.count; ++i) {
+    const Entry& entry = other.entries[i];
+    this->assign(this->add(entry.name, entry.nameSize), entry.value, entry.valueSize);
+  }
   return *this;
 }
 
+void Headers::swap(Headers& other) {
+  const bool ownsArena = this->arena == &this->memory;
+  const bool otherOwnsArena = other.arena == &other.memory;
+  this->memory.swap(other.memory);
+  std::swap(this->arena, other.arena);
+  if (otherOwnsArena)
+    this->arena = &this->memory;
+  if (ownsArena)
+    other.arena = &other.memory;
+  std::swap(this->entries, other.entries);
+  std::swap(this->count, other.count);
+  std::swap(this->capacity, other.capacity);
+  std::swap_ranges(this->index, this->index + Names::Unknown, other.index);
+}
+
 void Headers::clear() {
-  this->headers.clear();
-  this->keys.clear();
+  // a shared arena is reset by its owner
+  if (this->arena == &this->memory)
+    this->memory.reset();
+  this->entries = NULL;
+  this->count = 0;
+  this->capacity = 0;
+  std::fill(this->index, this->index + Names::Unknown, 0);
 }
 
-bool Headers::append(const std::string& key, const std::string& value) {
-  if (this->has(key))
+Headers::Entry* Headers::lookup(Names::Name name) const {
+  if (name >= Names::Unknown || this->index[name] == 0)
+    return NULL;
+  return &this->entries[this->index[name] - 1];
+}
+
+Headers::Entry* Headers::lookup(const char* key, size_t keySize) const {
+  trim(key, keySize);
+  const uint32_t hash = Headers::Hash(key, keySize);
+  const Names::Name name = FromHash(hash, key, keySize);
+  if (name != Names::Unknown)
+    return this->lookup(name);
+  for (size_t i = 0; i < this->count; ++i) {
+    const Entry& entry = this->entries[i];
+    if (entry.hash == hash && entry.nameSize == keySize && equals(entry.name, key, keySize))
+      return &this->entries[i];
+  }
+  return NULL;
+}
+
+Headers::Entry& Headers::push() {
+  if (this->count == this->capacity) {
+    // the old array stays in the arena until its reset
+    const size_t capacity = this->capacity ? this->capacity * 2 : initialCapacity;
+    Entry* entries = static_cast<Entry*>(this->arena->allocate(capacity * sizeof(Entry)));
+    if (this->count > 0)
+      std::memcpy(entries, this->entries, this->count * sizeof(Entry));
+    this->entries = entries;
+    this->capacity = capacity;
+  }
+  return this->entries[this->count++];
+}
+
+Headers::Entry& Headers::add(const char* key, size_t keySize) {
+  trim(key, keySize);
+  char* name = this->arena->copy(key, keySize);
+  for (size_t i = 0; i < keySize; ++i)
+    name[i] = std::tolower(static_cast<unsigned char>(name[i]));
+  Entry& entry = this->push();
+  entry.name = name;
+  entry.nameSize = keySize;
+  entry.value = "";
+  entry.valueSize = 0;
+  entry.hash = Headers::Hash(name, keySize);
+  entry.id = FromHash(entry.hash, name, keySize);
+  if (entry.id != Names::Unknown)
+    this->index[entry.id] = this->count;
+  return entry;
+}
+
+Headers::Entry& Headers::add(Names::Name name) {
+  Entry& entry = this->push();
+  // the table outlives any arena
+  entry.name = names[name];
+  entry.nameSize = std::strlen(names[name]);
+  entry.value = "";
+  entry.valueSize = 0;
+  entry.hash = NameHashes()[name];
+  entry.id = name;
+  this->index[name] = this->count;
+  return entry;
+}
+
+void Headers::assign(Entry& entry, const char* value, size_t valueSize) {
+  trim(value, valueSize);
+  entry.value = this->arena->copy(value, valueSize);
+  entry.valueSize = valueSize;
+}
+
+void Headers::removeAt(size_t i) {
+  if (this->entries[i].id != Names::Unknown)
+    this->index[this->entries[i].id] = 0;
+  std::memmove(this->entries + i, this->entries + i + 1, (this->count - i - 1) * sizeof(Entry));
+  this->count--;
+  // the ones after it moved down
+  for (; i < this->count; ++i)
+    if (this->entries[i].id != Names::Unknown)
+      this->index[this->entries[i].id] = i + 1;
+}
+
+bool Headers::append(const char* key, size_t keySize, const char* value, size_t valueSize) {
+  if (this->lookup(key, keySize))
+    return false;
+  this->assign(this->add(key, keySize), value, valueSize);
+  return true;
+}
+
+bool Headers::append(Names::Name name, const char* value, size_t valueSize) {
+  if (name >= Names::Unknown)
     return false;
-  std::string formatted = this->FormatKey(key);
-  std::string formattedValue = this->FormatValue(value);
-  this->headers.insert(std::make_pair(formatted, formattedValue));
-  this->keys.push_back(formatted);
+  if (this->lookup(name))
+    return false;
+  this->assign(this->add(name), value, valueSize);
   return true;
 }
 
+bool Headers::append(const std::string& key, const std::string& value) {
+  return this->append(key.data(), key.size(), value.data(), value.size());
+}
+
+void Headers::set(const std::string& key, const char* value, size_t valueSize) {
+  Entry* entry = this->lookup(key.data(), key.size());
+  if (!entry)
+    entry = &this->add(key.data(), key.size());
+  this->assign(*entry, value, valueSize);
+}
+
 void Headers::remove(const std::string& key) {
-  std::string formatted = this->FormatKey(key);
-  if (!this->has(formatted))
-    return;
-  this->headers.erase(formatted);
-  std::vector<std::string>::iterator it = std::find(this->keys.begin(), this->keys.end(), formatted);
-  if (it != this->keys.end())
-    this->keys.erase(it);
+  const Entry* entry = this->lookup(key.data(), key.size());
+  if (entry)
+    this->removeAt(entry - this->entries);
+}
+
+void Headers::remove(Names::Name name) {
+  const Entry* entry = this->lookup(name);
+  if (entry)
+    this->removeAt(entry - this->entries);
 }
 
 bool Headers::has(const std::string& key) const {
-  std::string formatted = this->FormatKey(key);
-  return this->headers.find(formatted) != this->headers.end();
+  return this->lookup(key.data(), key.size()) != NULL;
 }
 
+bool Headers::has(const char* key) const {
+  return this->lookup(key, std::strlen(key)) != NULL;
+}
 
+bool Headers::has(Names::Name name) const {
+  return this->lookup(name) != NULL;
+}
 
-const std::map<std::string, std::string>& Headers::getAll() const {
-  return this->headers;
+const Headers::Entry* Headers::find(const std::string& key) const {
+  return this->lookup(key.data(), key.size());
+}
+
+const Headers::Entry* Headers::find(Names::Name name) const {
+  return this->lookup(name);
+}
+
+bool Headers::getNumber(Names::Name name, uint64_t& value) const {
+  const Entry* entry = this->lookup(name);
+  return entry && Headers::ParseNumber(entry->value, entry->valueSize, value);
 }
 
 Headers::operator std::string() const {
@@ -67,25 +312,25 @@ Headers::operator std::string() const {
 }
 
 std::string Headers::toString() const {
-  std::string result;
-  for (
-    std::vector<std::string>::const_iterator it = this->keys.begin();
-    it != this->keys.end();
-    it++) {
-    std::string key = *it;
-    if (!this->headers.count(key)) {
-      Logger::error
-        << "Headers key " << Logger::param(key) << " not found in headers map"
-        << std::newl;
-      continue;
-    }
-    const std::string& value = this->headers.at(key);
-    result += HTTP::capitalizeHeader(key) + ": " + value + "\r\n";
-  }
-  return result;
+  std::stringstream ss;
+  ss << *this;
+  return ss.str();
 }
 
 std::ostream& HTTP::operator<<(std::ostream& os, const Headers& headers) {
-  os << headers.toString();
+  // i.e. a disabled log stream
+  if (!os.good())
+    return os;
+  for (size_t i = 0; i < headers.count; ++i) {
+    const Headers::Entry& entry = headers.entries[i];
+    // capitalized on the way out, Content-Type, not content-type
+    bool upper = true;
+    for (size_t j = 0; j < entry.nameSize; ++j) {
+      const char c = entry.name[j];
+      os.put(upper ? std::toupper(static_cast<unsigned char>(c)) : c);
+      upper = c == '-';
+    }
+    os.write(": ", 2).write(entry.value, entry.valueSize).write("\r\n", 2);
+  }
   return os;
-}
\ No newline at end of file
+}
@@ -1,14 +1,27 @@
 #include "http/Methods.hpp"
 #include <utils/misc.hpp>
+#include <cstring>
 
 using namespace HTTP;
 
 Methods::Method Methods::FromString(const std::string& str) {
-  if (str == "GET") return GET;
-  if (str == "POST") return POST;
-  if (str == "PUT") return PUT;
-  if (str == "DELETE") return DELETE;
-  if (str == "HEAD") return HEAD;
+  return FromString(str.data(), str.size());
+}
+
+Methods::Method Methods::FromString(const char* str, size_t size) {
+  switch (size) {
+    case 3:
+      if (std::memcmp(str, "GET", 3) == 0) return GET;
+      if (std::memcmp(str, "PUT", 3) == 0) return PUT;
+      break;
+    case 4:
+      if (std::memcmp(str, "POST", 4) == 0) return POST;
+      if (std::memcmp(str, "HEAD", 4) == 0) return HEAD;
+      break;
+    case 6:
+      if (std::memcmp(str, "DELETE", 6) == 0) return DELETE;
+      break;
+  }
   return UNK;
 }
 
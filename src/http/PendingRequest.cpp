@@ -11,6 +11,8 @@ std::string PendingRequest::States::ToString(State state) {
   case States::Headers: return "Headers";
   case States::BodyChunkSize: return "BodyChunkSize";
   case States::BodyChunkData: return "BodyChunkData";
+  case States::BodyChunkEnd: return "BodyChunkEnd";
+  case States::BodyTrailers: return "BodyTrailers";
   case States::Done: return "Done";
   default:
     return "UNK" + Utils::toString(state);
@@ -21,11 +23,14 @@ PendingRequest::PendingRequest(
   Socket::Parallel* server,
   Socket::Connection* client
 ) :
-  Request(server, client, Methods::UNK, "", ByteStream(), "", Headers(), std::map<std::string, std::string>(), std::vector<File>()),
+  Request(),
   state(States::Uri),
-  buildingHeaderKey(""),
+  parser(),
   chunkSize(0),
-  chunkData() {}
+  maxBodySize(0) {
+  this->server = server;
+  this->client = client;
+}
 
 PendingRequest::PendingRequest() {}
 PendingRequest::~PendingRequest() {}
@@ -33,15 +38,17 @@ PendingRequest::~PendingRequest() {}
 PendingRequest::PendingRequest(const PendingRequest& other) :
   Request(other),
   state(other.state),
-  storage(other.storage),
-  buildingHeaderKey(other.buildingHeaderKey) {}
+  parser(other.parser),
+  chunkSize(other.chunkSize),
+  maxBodySize(other.maxBodySize) {}
 
 PendingRequest& PendingRequest::operator=(const PendingRequest& other) {
   if (this == &other) return *this;
   this->Request::operator=(other);
   this->state = other.state;
-  this->storage = other.storage;
-  this->buildingHeaderKey = other.buildingHeaderKey;
+  this->parser = other.parser;
+  this->chunkSize = other.chunkSize;
+  this->maxBodySize = other.maxBodySize;
   return *this;
 }
 
@@ -73,7 +80,30 @@ void PendingRequest::setMethod(const Methods::Method method) {
 }
 
 void PendingRequest::setPath(const std::string& path) {
-  this->path = Utils::resolvePath(1, path.c_str());
+  this->setPath(path.data(), path.size());
+}
+
+void PendingRequest::setPath(const char* path, size_t size) {
+  this->path.assign(path, size);
+  this->params.clear();
+  this->parseQuery();
+}
+
+void PendingRequest::reset() {
+  Utils::Arena& arena = this->client->getArena();
+  // nothing of the last request is used anymore
+  arena.reset();
+  Headers(arena).swap(this->headers);
+  this->method = Methods::UNK;
+  this->path.clear();
+  this->body.clear();
+  this->protocol.clear();
+  this->params.clear();
+  this->files.clear();
+  this->state = States::Uri;
+  this->parser.reset();
+  this->chunkSize = 0;
+  this->maxBodySize = 0;
 }
 
 PendingRequest::Protocol PendingRequest::getProtocol() const {
@@ -120,24 +150,12 @@ void PendingRequest::setVersionMinor(const int versionMinor) {
   this->protocol = protocol;
 }
 
-void PendingRequest::setBody(const std::string& body) {
-  this->body.clear();
-  this->body.put(body);
-}
-
-void PendingRequest::setBody(const ByteStream& body) {
-  this->body = body;
-}
-
-void PendingRequest::addToBody(const std::string& body) {
-  this->body.put(body);
+RequestBody& PendingRequest::getBody() {
+  return this->body;
 }
 
 void PendingRequest::addToBody(const ByteStream& body, size_t size) {
-  if (size == static_cast<size_t>(-1))
-    this->body.put(body);
-  else
-    this->body.put(body, size);
+  this->body.write(body.data(), size);
 }
 
 void PendingRequest::setHeaders(const Headers& headers) {
@@ -154,7 +172,7 @@ std::ostream& HTTP::operator<<(std::ostream& os, const PendingRequest& req) {
     << req.Request::getProtocol()
     << ") -> headers:\n"
     << req.getHeaders()
-    << "\nPendingBodySize: " << Logger::param(req.chunkData.size())
+    << "\nPendingChunkSize: " << Logger::param(req.chunkSize)
     // << " -> body:\n"
     // << "---" << std::newl
     // << req.getRawBody()
@@ -162,22 +180,3 @@ std::ostream& HTTP::operator<<(std::ostream& os, const PendingRequest& req) {
     << std::newl;
   return os;
 }
-
-bool PendingRequest::lastCheck() {
-  switch (this->getState()) {
-  case States::Done:
-    return true;
-  case States::Body:
-    if (this->chunkData.size() == this->getContentLength()) {
-      this->setBody(this->chunkData);
-      this->reset(true);
-      return true;
-    }
-    return false;
-  case States::BodyChunkSize:
-  case States::BodyChunkData:
-    return this->chunkSize == 0;
-  default:
-    return false;
-  }
-}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "http/Request.hpp"
 #include <utils/misc.hpp>
+#include <strings.h>
+#include <cctype>
 
 using namespace HTTP;
 
@@ -8,7 +10,7 @@ Request::Request(
   Socket::Connection* client,
   Methods::Method method,
   const std::string& path,
-  const ByteStream& body,
+  const RequestBody& body,
   const std::string& protocol,
   const Headers& headers,
   const std::map<std::string, std::string>& params,
@@ -26,7 +28,10 @@ Request::Request(
   this->parseParams();
 }
 
-Request::Request() {}
+Request::Request()
+  : headers(), method(Methods::UNK), path(), body(), protocol(),
+  server(NULL), client(NULL), params(), files() {}
+
 Request::~Request() {}
 
 Request::Request(const Request& other) :
@@ -38,9 +43,7 @@ Request::Request(const Request& other) :
   server(other.server),
   client(other.client),
   params(other.params),
-  files(other.files) {
-  this->parseParams();
-}
+  files(other.files) {}
 
 Request& Request::operator=(const Request& other) {
   if (this == &other) return *this;
@@ -53,7 +56,6 @@ Request& Request::operator=(const Request& other) {
   this->client = other.client;
   this->params = other.params;
   this->files = other.files;
-  this->parseParams();
   return *this;
 }
 
@@ -89,39 +91,92 @@ Socket::Server& Request::getServer() {
   return this->server->getServer(this->client->getServerSock());
 }
 
+bool Request::isKeepAlive() const {
+  bool keepAlive = this->protocol == "HTTP/1.1";
+  const Headers::Entry* connection = this->headers.find(Headers::Names::Connection);
+  if (!connection)
+    return keepAlive;
+  // comma separated tokens, compared in place
+  const char* it = connection->value;
+  const char* end = it + connection->valueSize;
+  while (it < end) {
+    const char* next = std::find(it, end, ',');
+    const char* last = next;
+    while (it < last && std::isspace(static_cast<unsigned char>(*it)))
+      it++;
+    while (last > it && std::isspace(static_cast<unsigned char>(last[-1])))
+      last--;
+    const size_t size = last - it;
+    if (size == 5 && strncasecmp(it, "close", 5) == 0)
+      return false;
+    if (size == 10 && strncasecmp(it, "keep-alive", 10) == 0)
+      keepAlive = true;
+    it = next + 1;
+  }
+  return keepAlive;
+}
+
 const std::map<std::string, std::string>& Request::getParams() const {
   return this->params;
 }
 
 void Request::parseParams() {
-  {
-    std::string query;
-    std::string::size_type pos = this->path.find('?');
-    if (pos != std::string::npos) {
-      query = this->path.substr(pos + 1);
-      this->path = this->path.substr(0, pos);
-    }
-    std::vector<std::string> pairs = Utils::split(query, "&");
-    for (std::vector<std::string>::iterator it = pairs.begin(); it != pairs.end(); it++) {
-      std::vector<std::string> pair = Utils::split(*it, "=");
-      if (pair.size() == 2)
-        this->params[pair[0]] = pair[1];
+  this->parseQuery();
+  this->parseBodyParams();
+}
+
+// key=value pairs of str[start, end), split on '&'
+// like Utils::split, empty pieces are skipped & pairs that aren't exactly a key & a value are ignored
+static void parsePairs(const std::string& str, size_t start, size_t end, std::map<std::string, std::string>& params) {
+  while (start < end) {
+    size_t pairEnd = str.find('&', start);
+    if (pairEnd == std::string::npos || pairEnd > end)
+      pairEnd = end;
+    size_t pieces[2][2];
+    size_t count = 0;
+    for (size_t i = start; i < pairEnd;) {
+      size_t j = str.find('=', i);
+      if (j == std::string::npos || j > pairEnd)
+        j = pairEnd;
+      if (j > i && count++ < 2) {
+        pieces[count - 1][0] = i;
+        pieces[count - 1][1] = j;
+      }
+      i = j + 1;
     }
+    if (count == 2)
+      params[str.substr(pieces[0][0], pieces[0][1] - pieces[0][0])] = str.substr(pieces[1][0], pieces[1][1] - pieces[1][0]);
+    start = pairEnd + 1;
   }
-  const Headers& headers = this->getHeaders();
-  if (headers.has("Content-Type") && headers.get<std::string>("Content-Type") == "application/x-www-form-urlencoded") {    
-    std::vector<std::string> pairs = Utils::split(this->getBody(), "&");
-    for (std::vector<std::string>::iterator it = pairs.begin(); it != pairs.end(); it++) {
-      std::vector<std::string> pair = Utils::split(*it, "=");
-      if (pair.size() == 2)
-        this->params[pair[0]] = pair[1];
-    }
+}
+
+void Request::parseQuery() {
+  std::string::size_type pos = this->path.find('?');
+  if (pos != std::string::npos) {
+    parsePairs(this->path, pos + 1, this->path.size(), this->params);
+    this->path.erase(pos);
   }
   Logger::debug << "Request::parseParams" << "pre-path: " << this->path << std::endl;
-  this->path = Utils::resolvePath(1, Utils::decodeURIComponent(this->path).c_str());
+  if (this->path.find('%') != std::string::npos) {
+    this->path = Utils::decodeURIComponent(this->path);
+    // a decoded NUL ends it, as it did when it went through a C string
+    this->path.erase(std::min(this->path.find('\0'), this->path.size()));
+  }
   Logger::debug << "Request::parseParams" << "post-path: " << this->path << std::endl;
 }
 
+void Request::parseBodyParams() {
+  const Headers::Entry* contentType = this->getHeaders().find(Headers::Names::ContentType);
+  // spilled bodies are too big to be form params
+  if (
+    contentType && contentType->is("application/x-www-form-urlencoded")
+    && !this->body.isFile()
+  ) {
+    const std::string body = this->body.toString();
+    parsePairs(body, 0, body.size(), this->params);
+  }
+}
+
 std::ostream& HTTP::operator<<(std::ostream& os, const Request& req) {
   os
     << "Request("
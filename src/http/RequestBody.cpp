@@ -0,0 +1,178 @@
+#include "http/RequestBody.hpp"
+#include <Settings.hpp>
+#include <utils/Logger.hpp>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+using HTTP::RequestBody;
+
+static Settings* settings = Instance::Get<Settings>();
+
+// saved files get the same mode as the ones open creates
+static mode_t SavedFileMode() {
+  static mode_t mode = 0;
+  static bool resolved = false;
+  if (!resolved) {
+    // umask can only be read by setting it
+    const mode_t mask = ::umask(0);
+    ::umask(mask);
+    mode = 0644 & ~mask;
+    resolved = true;
+  }
+  return mode;
+}
+
+RequestBody::Storage::Storage() : data(), fd(-1), path(), size(0), refs(1) {}
+
+RequestBody::Storage::~Storage() {
+  if (this->fd < 0)
+    return;
+  ::close(this->fd);
+  if (!this->path.empty())
+    ::unlink(this->path.c_str());
+}
+
+RequestBody::RequestBody() : storage(NULL) {}
+
+RequestBody::~RequestBody() {
+  this->release();
+}
+
+RequestBody::RequestBody(const RequestBody& other) : storage(other.storage) {
+  if (this->storage)
+    this->storage->refs++;
+}
+
+RequestBody& RequestBody::operator=(const RequestBody& other) {
+  if (this == &other || this->storage == other.storage) return *this;
+  this->release();
+  this->storage = other.storage;
+  if (this->storage)
+    this->storage->refs++;
+  return *this;
+}
+
+const RequestBody::Storage& RequestBody::getStorage() const {
+  static const Storage empty;
+  return this->storage ? *this->storage : empty;
+}
+
+void RequestBody::release() {
+  if (this->storage && --this->storage->refs == 0)
+    delete this->storage;
+  this->storage = NULL;
+}
+
+void RequestBody::clear() {
+  this->release();
+}
+
+void RequestBody::write(const void* data, uint64_t size) {
+  const uint64_t maxMemory = settings->getSnapshot().requestBodyMaxMemory;
+  if (size == 0)
+    return;
+  if (!this->storage)
+    this->storage = new Storage();
+  Storage& storage = *this->storage;
+  if (!this->isFile() && storage.size + size > maxMemory)
+    this->spill();
+  if (!this->isFile()) {
+    storage.data.resize(storage.size + size);
+    std::memcpy(storage.data.data() + storage.size, data, size);
+    storage.size += size;
+    return;
+  }
+  const char* bytes = static_cast<const char*>(data);
+  for (uint64_t written = 0; written < size;) {
+    const ssize_t bytesWritten = ::write(storage.fd, bytes + written, size - written);
+    if (bytesWritten < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error("Could not write request body to " + storage.path + ": " + std::strerror(errno));
+    }
+    written += bytesWritten;
+  }
+  storage.size += size;
+}
+
+void RequestBody::spill() {
+  const std::string& tempDir = settings->getSnapshot().requestBodyTempDir;
+  Storage& storage = *this->storage;
+  std::string path = tempDir + "/webserv-body-XXXXXX";
+  const int fd = ::mkstemp(&path[0]);
+  if (fd < 0)
+    throw std::runtime_error("Could not create a temp file in " + tempDir + ": " + std::strerror(errno));
+  ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+  storage.fd = fd;
+  storage.path = path;
+  Logger::debug
+    << "Spilling request body of " << Logger::param(storage.size)
+    << " bytes to " << Logger::param(path) << std::newl;
+  // what was in memory goes first
+  ByteStream data;
+  data.swap(storage.data);
+  storage.size = 0;
+  this->write(data.data(), data.size());
+}
+
+std::string RequestBody::toString() const {
+  const Storage& storage = this->getStorage();
+  if (!this->isFile())
+    return std::string(reinterpret_cast<const char*>(storage.data.data()), storage.size);
+  std::string content(storage.size, '\0');
+  for (uint64_t done = 0; done < storage.size;) {
+    const ssize_t bytesRead = ::pread(storage.fd, &content[done], storage.size - done, done);
+    if (bytesRead < 0 && errno == EINTR)
+      continue;
+    if (bytesRead <= 0)
+      throw std::runtime_error("Could not read request body from " + storage.path + ": " + std::strerror(errno));
+    done += bytesRead;
+  }
+  return content;
+}
+
+bool RequestBody::saveTo(const std::string& path) {
+  const Storage& storage = this->getStorage();
+  // mkstemp creates it as 0600
+  if (this->isFile() && ::fchmod(storage.fd, SavedFileMode()) == 0 && ::rename(storage.path.c_str(), path.c_str()) == 0) {
+    // it's not ours to delete anymore
+    this->storage->path.clear();
+    this->clear();
+    return true;
+  }
+  // in memory, or the temp dir is on another filesystem (EXDEV), copy it
+  if (this->isFile() && errno != EXDEV)
+    return false;
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, SavedFileMode());
+  if (fd < 0)
+    return false;
+  char buffer[65536];
+  for (uint64_t done = 0; done < storage.size;) {
+    ssize_t bytes;
+    if (this->isFile()) {
+      bytes = ::pread(storage.fd, buffer, std::min<uint64_t>(sizeof(buffer), storage.size - done), done);
+      if (bytes > 0)
+        bytes = ::write(fd, buffer, bytes);
+    }
+    else
+      bytes = ::write(fd, storage.data.data() + done, storage.size - done);
+    if (bytes < 0 && errno == EINTR)
+      continue;
+    if (bytes <= 0) {
+      const int error = errno;
+      ::close(fd);
+      errno = error;
+      return false;
+    }
+    done += bytes;
+  }
+  ::close(fd);
+  this->clear();
+  return true;
+}
@@ -0,0 +1,188 @@
+#include "http/RequestParser.hpp"
+#include "http/ErrorCodes.hpp"
+#include <http/utils.hpp>
+#include <http/scan.hpp>
+#include <Settings.hpp>
+#include <cstring>
+
+using HTTP::RequestParser;
+
+static Settings* settings = Instance::Get<Settings>();
+
+uint64_t RequestParser::FindLine(const ByteStream& buffer, uint64_t from) {
+  if (from >= buffer.size())
+    return npos;
+  const char* data = reinterpret_cast<const char*>(buffer.data());
+  const uint64_t eol = from + Scan::find(data + from, buffer.size() - from, '\n');
+  return eol == buffer.size() ? npos : eol;
+}
+
+std::string RequestParser::ToString(const ByteStream& buffer, const Span& span) {
+  return std::string(reinterpret_cast<const char*>(buffer.data()) + span.offset, span.size);
+}
+
+RequestParser::RequestParser()
+  : state(States::RequestLine), cursor(0), scanned(0), method(Methods::UNK),
+  target(), protocol(), headers(), errorCode(0), error() {}
+
+RequestParser::~RequestParser() {}
+
+RequestParser::RequestParser(const RequestParser& other)
+  : state(other.state), cursor(other.cursor), scanned(other.scanned), method(other.method),
+  target(other.target), protocol(other.protocol), headers(other.headers),
+  errorCode(other.errorCode), error(other.error) {}
+
+RequestParser& RequestParser::operator=(const RequestParser& other) {
+  if (this == &other) return *this;
+  this->state = other.state;
+  this->cursor = other.cursor;
+  this->scanned = other.scanned;
+  this->method = other.method;
+  this->target = other.target;
+  this->protocol = other.protocol;
+  this->headers = other.headers;
+  this->errorCode = other.errorCode;
+  this->error = other.error;
+  return *this;
+}
+
+void RequestParser::reset() {
+  this->state = States::RequestLine;
+  this->cursor = 0;
+  this->scanned = 0;
+  this->method = Methods::UNK;
+  this->target = Span();
+  this->protocol = Span();
+  this->headers.clear();
+  this->errorCode = 0;
+  this->error.clear();
+}
+
+RequestParser::Results::Result RequestParser::parse(const ByteStream& buffer) {
+  const char* data = reinterpret_cast<const char*>(buffer.data());
+  while (this->state != States::Done) {
+    const uint64_t eol = RequestParser::FindLine(buffer, this->scanned);
+    if (eol == npos) {
+      // only the new bytes get scanned next time
+      this->scanned = buffer.size();
+      return Results::Incomplete;
+    }
+    this->scanned = eol + 1;
+    if (eol == this->cursor || data[eol - 1] != '\r') {
+      this->fail(ErrorCodes::BadRequest, "Line not terminated by CRLF");
+      return Results::Error;
+    }
+    const Span line(this->cursor, eol - 1 - this->cursor);
+    this->cursor = this->scanned;
+    switch (this->state) {
+      case States::RequestLine:
+        // empty lines before the request line are ignored
+        if (line.size == 0)
+          break;
+        if (!this->parseRequestLine(data, line))
+          return Results::Error;
+        this->state = States::Headers;
+        break;
+      case States::Headers:
+        if (line.size == 0) {
+          this->state = States::Done;
+          break;
+        }
+        if (!this->parseHeader(data, line))
+          return Results::Error;
+        break;
+      default:
+        break;
+    }
+  }
+  return Results::Done;
+}
+
+bool RequestParser::parseRequestLine(const char* data, const Span& line) {
+  const size_t maxUriSize = settings->getSnapshot().maxUriSize;
+  Span parts[3];
+  size_t count = 0;
+  const uint64_t end = line.offset + line.size;
+  for (uint64_t i = line.offset; i < end;) {
+    while (i < end && data[i] == ' ')
+      i++;
+    if (i == end)
+      break;
+    const uint64_t start = i;
+    i += Scan::find(data + i, end - i, ' ');
+    if (count == 3)
+      return this->fail(ErrorCodes::BadRequest, "Invalid URI " + std::string(data + line.offset, line.size) + " (invalid parts)");
+    parts[count++] = Span(start, i - start);
+  }
+  if (count != 3)
+    return this->fail(ErrorCodes::BadRequest, "Invalid URI " + std::string(data + line.offset, line.size) + " (invalid parts)");
+  { // Handle Method
+    const Span& method = parts[0];
+    this->method = Methods::FromString(data + method.offset, method.size);
+    if (this->method == Methods::UNK)
+      return this->fail(ErrorCodes::NotImplemented, "Unknown method " + std::string(data + method.offset, method.size));
+  }
+  { // Handle URL
+    const Span& path = parts[1];
+    if (data[path.offset] != '/' || HTTP::hasDisallowedUriToken(data + path.offset, path.size))
+      return this->fail(ErrorCodes::BadRequest, "Invalid URI " + std::string(data + line.offset, line.size) + " (disallowed token)");
+    if (path.size > maxUriSize)
+      return this->fail(ErrorCodes::URITooLong, "URI too long " + std::string(data + path.offset, path.size));
+    this->target = path;
+  }
+  { // Handle Protocol
+    const Span& protocol = parts[2];
+    const char* str = data + protocol.offset;
+    const char* slash = static_cast<const char*>(std::memchr(str, '/', protocol.size));
+    if (!slash || slash == str || slash == str + protocol.size - 1)
+      return this->fail(ErrorCodes::BadRequest, "Invalid protocol " + std::string(str, protocol.size));
+    if (slash - str != 4 || std::memcmp(str, "HTTP", 4) != 0)
+      return this->fail(ErrorCodes::BadRequest, "Invalid protocol " + std::string(str, slash - str));
+    if (protocol.size != 8 || std::memcmp(slash, "/1.1", 4) != 0)
+      return this->fail(ErrorCodes::HTTPVersionNotSupported, "Invalid protocol version " + std::string(str, protocol.size));
+    this->protocol = protocol;
+  }
+  return true;
+}
+
+bool RequestParser::parseHeader(const char* data, const Span& line) {
+  const char* str = data + line.offset;
+  Header header;
+  // usual case, the name is only made of tokens up to the ':', no need to check it again
+  uint64_t sepPos = Scan::findNonFieldToken(str, line.size);
+  const bool isTokenName = sepPos != line.size && str[sepPos] == ':';
+  if (!isTokenName)
+    sepPos = Scan::find(str, line.size, ':');
+  if (sepPos != line.size) { // handle ':' case
+    if (sepPos == 0 || sepPos == line.size - 1)
+      return this->fail(ErrorCodes::BadRequest, "Invalid header " + std::string(str, line.size));
+    if (!isTokenName && HTTP::hasFieldToken(str, sepPos))
+      return this->fail(ErrorCodes::BadRequest, "Invalid header " + std::string(str, sepPos));
+    header.name = Span(line.offset, sepPos);
+    // without the surrounding whitespace
+    uint64_t start = line.offset + sepPos + 1;
+    uint64_t end = line.offset + line.size;
+    while (start < end && (data[start] == ' ' || data[start] == '\t'))
+      start++;
+    while (end > start && (data[end - 1] == ' ' || data[end - 1] == '\t'))
+      end--;
+    header.value = Span(start, end - start);
+    this->headers.push_back(header);
+    return true;
+  }
+  sepPos = Scan::find(str, line.size, ';');
+  if (sepPos != line.size) { // handle ';' case
+    if (HTTP::hasFieldToken(str, sepPos))
+      return this->fail(ErrorCodes::BadRequest, "Invalid header " + std::string(str, sepPos));
+    header.name = Span(line.offset, sepPos);
+    this->headers.push_back(header);
+    return true;
+  }
+  return this->fail(ErrorCodes::BadRequest, "Invalid header " + std::string(str, line.size));
+}
+
+bool RequestParser::fail(int code, const std::string& error) {
+  this->errorCode = code;
+  this->error = error;
+  return false;
+}
@@ -1,4 +1,5 @@
 #include "http/Response.hpp"
+#include "http/ChunkedFile.hpp"
 
 #include <utils/misc.hpp>
 #include <utils/Logger.hpp>
@@ -9,6 +10,7 @@ using HTTP::Request;
 using HTTP::Headers;
 using HTTP::Response;
 using HTTP::Route;
+using Socket::WriteQueue;
 
 static const Settings* settings = Instance::Get<Settings>();
 
@@ -24,6 +26,18 @@ Response::Response(const Request& request, const Route* route)
   this->init();
 }
 
+Response::Response(const Request& request, const Route* route, Utils::Arena& arena)
+  :
+  req(&request),
+  headers(arena),
+  body(),
+  statusCode(-1),
+  statusMessage(),
+  sent(),
+  route(route) {
+  this->init();
+}
+
 Response::~Response() {}
 
 Response::Response(const Response& other)
@@ -34,9 +48,7 @@ Response::Response(const Response& other)
   statusCode(other.statusCode),
   statusMessage(other.statusMessage),
   sent(other.sent),
-  route(other.route) {
-  this->init();
-}
+  route(other.route) {}
 
 Response& Response::operator=(const Response& other) {
   if (this == &other)
@@ -48,17 +60,39 @@ Response& Response::operator=(const Response& other) {
   this->statusMessage = other.statusMessage;
   this->sent = other.sent;
   this->route = other.route;
-  this->init();
   return *this;
 }
 
 void Response::init() {
-  this->headers.append("Server", settings->get<std::string>("misc.name"));
-  this->headers.append("Date", Utils::getJSONDate());
-  if (this->req->getHeaders().has("Connection"))
-    this->headers.append("Connection", this->req->getHeaders().get<std::string>("Connection"));
-  else if (!this->req->isExpecting() || this->req->getProtocol() == "HTTP/1.0")
-    this->headers.append("Connection", "close");
+  this->headers.append(Headers::Names::Server, settings->getSnapshot().name);
+  this->headers.append(Headers::Names::Date, Utils::getHTTPDate());
+  if (!this->headers.has(Headers::Names::Connection))
+    this->setupConnectionHeaders();
+}
+
+void Response::setupConnectionHeaders() {
+  const Socket::Connection& client = this->req->getClient();
+  const uint32_t maxRequests = client.getMaxRequests();
+  const bool keepAlive = this->req->isKeepAlive()
+    && (maxRequests == 0 || client.getRequestCount() < maxRequests);
+  if (!keepAlive) {
+    this->headers.set("Connection", "close");
+    this->headers.remove(Headers::Names::KeepAlive);
+    return;
+  }
+  std::stringstream ss;
+  // in seconds, rounded down so clients never count on more idle time than the server keeps,
+  // left out under a second rather than advertising 0
+  const int timeout = client.getTimeout() / 1000;
+  if (timeout > 0)
+    ss << "timeout=" << timeout;
+  if (maxRequests > 0)
+    ss << (timeout > 0 ? ", " : "") << "max=" << maxRequests - client.getRequestCount();
+  this->headers.set("Connection", "keep-alive");
+  if (ss.tellp() > 0)
+    this->headers.set("Keep-Alive", ss.str());
+  else
+    this->headers.remove(Headers::Names::KeepAlive);
 }
 
 
@@ -140,11 +174,11 @@ std::string Response::getHeader() const {
 void Response::sendHeader() {
   const std::string header = this->getHeader() + "\r\n";
   Socket::Connection& client = const_cast<Request*>(this->req)->getClient();
-  Logger::info
-    << "Sending headers to: " << Logger::param(client) << std::newl
-    << Logger::param(header) << std::newl;
-  ByteStream& buffer = client.getWriteBuffer();
-  buffer.put(header);
+  if (Logger::info.isEnabled())
+    Logger::info
+      << "Sending headers to: " << Logger::param(client) << std::newl
+      << Logger::param(header) << std::newl;
+  client.getWriteQueue().push(header);
   this->afterSend();
 }
 
@@ -158,13 +192,16 @@ void Response::send() {
     }
   }
   this->_preSend();
-  const ByteStream resp = this->toString<ByteStream>();
   Socket::Connection& client = const_cast<Request*>(this->req)->getClient();
-  Logger::info
-    << "Sending response to: " << Logger::param(client) << std::newl
-    << Logger::param(*this) << std::newl;
-  ByteStream& buffer = client.getWriteBuffer();
-  buffer.put(resp);
+  if (Logger::info.isEnabled())
+    Logger::info
+      << "Sending response to: " << Logger::param(client) << std::newl
+      << Logger::param(*this) << std::newl;
+  WriteQueue& queue = client.getWriteQueue();
+  queue.push(this->getHeader() + "\r\n");
+  // the body is handed over to the queue, not copied
+  if (this->req->getMethod() != Methods::HEAD)
+    queue.push(this->body);
   this->afterSend();
 }
 
@@ -174,61 +211,32 @@ void Response::redirect(const std::string& path, bool permanent) {
   this->send();
 }
 
-void Response::_sendChunk(const char* buffer, std::istream& stream, bool last) {
-  Socket::Connection& client = const_cast<Request*>(this->req)->getClient();
-
-  ByteStream chunk;
-  std::stringstream chunkBytes;
-  const size_t chunkSize = stream.gcount();
-  if (chunkSize > 0) {
-    Logger::debug
-      << "Sending chunk of size: " << Logger::param(chunkSize) << std::newl;
-    chunkBytes << std::hex << chunkSize << "\r\n";
-    chunk.put(chunkBytes.str());
-    chunk.put(buffer, chunkSize);
-    chunk.put("\r\n");
-  }
-  if (last)
-    chunk.put("0\r\n\r\n");
-  // << Logger::param(chunk.str()) << std::newl;
-  ByteStream& buff = client.getWriteBuffer();
-  buff.put(chunk);
-  if (last)
-    this->afterSend();
-}
-
 void Response::_preSend() {
-  if (!this->headers.has("Content-Length"))
+  if (!this->headers.has(Headers::Names::ContentLength))
     this->headers.set("Content-Length", this->body.size());
 }
 
 void Response::_preStream(const std::string& filePath) {
   this->headers.set("Transfer-Encoding", "chunked");
-  this->headers.remove("Content-Length");
+  this->headers.remove(Headers::Names::ContentLength);
   const std::string ext = Utils::getExtension(filePath);
   this->headers.set("Content-Type", settings->httpMimeType(ext));
 }
 
-void Response::stream(std::istream& buff, size_t fileSize /* = 0 */) {
-  if (this->req->getMethod() == Methods::HEAD)
-    return;
-  static const uint64_t nbrOfChunks = settings->get<uint64_t>("http.static.file_chunks");
-  static const uint64_t minChunkSize = settings->get<uint64_t>("http.static.file_chunk_size");
+uint64_t Response::_getChunkSize(uint64_t fileSize) const {
+  const uint64_t nbrOfChunks = settings->getSnapshot().fileChunks;
+  const uint64_t minChunkSize = settings->getSnapshot().fileChunkSize;
+  const uint64_t maxChunkSize = settings->getSnapshot().writeBufferSize;
 
   uint64_t n;
   if (fileSize == 0 || fileSize < minChunkSize)
-    n = settings->get<uint64_t>("http.static.file_chunk_size");
+    n = minChunkSize;
   else
     n = fileSize / nbrOfChunks;
   if (fileSize > 0 && n > fileSize)
     n = fileSize;
-  Logger::debug
-    << "Streaming file with chunk size: " << Logger::param(n) << std::newl;
-  char buffer[n];
-  while (buff.read(buffer, n))
-    this->_sendChunk(buffer, buff);
-
-  this->_sendChunk(buffer, buff, true);
+  // a chunk is produced each time the write queue runs low, keep it bounded
+  return std::min(n, maxChunkSize);
 }
 
 void Response::sendFile(
@@ -236,35 +244,97 @@ void Response::sendFile(
   bool stream /* = true */,
   struct stat* fileStat /* = NULL */
 ) {
-  stream = true;
-  std::ifstream file(filePath.c_str());
+  if (!stream)
+    return this->_sendRawFile(filePath);
+  struct stat tmp;
+  ChunkedFile* file = NULL;
   try {
-    if (!file.is_open() || !file.good())
+    if (fileStat == nullptr) {
+      fileStat = &tmp;
+      if (stat(filePath.c_str(), fileStat) == -1)
+        throw std::runtime_error("Could not stat file " + filePath);
+    }
+    file = new ChunkedFile(filePath, this->_getChunkSize(fileStat->st_size));
+    if (!file->isOpen())
       throw std::runtime_error("Could not open file " + filePath);
     this->setupStaticFileHeaders(filePath, fileStat);
-    if (stream) {
-      this->_preStream(filePath);
-      this->sendHeader();
-      this->stream(reinterpret_cast<std::istream&>(file), fileStat ? fileStat->st_size : 0);
-    }
-    else {
-      std::stringstream ss;
-      ss << file.rdbuf();
-      this->send(ss.str());
-    }
-    file.close();
+    this->_preStream(filePath);
+    this->sendHeader();
   }
   catch (const std::exception& e) {
-    file.close();
+    delete file;
     Logger::error
       << "Could not send file " << Logger::param(filePath) << ": " << e.what() << std::newl;
     this->status(500).send();
+    return;
+  }
+  if (this->req->getMethod() == Methods::HEAD) {
+    delete file;
+    return;
+  }
+  Logger::debug
+    << "Streaming file " << Logger::param(filePath)
+    << " with chunk size: " << Logger::param(this->_getChunkSize(fileStat->st_size)) << std::newl;
+  // chunks are read as the client drains its write queue
+  Socket::Connection& client = const_cast<Request*>(this->req)->getClient();
+  client.getWriteQueue().pushProducer(file);
+}
+
+void Response::_sendRawFile(const std::string& filePath) {
+  const FileCache::Entry* file = Instance::Get<FileCache>()->get(filePath);
+  if (!file) {
+    Logger::error
+      << "Could not send file " << Logger::param(filePath) << ": not a readable regular file" << std::newl;
+    this->status(500).send();
+    return;
+  }
+  this->sendFile(*file);
+}
+
+void Response::sendFile(const FileCache::Entry& file) {
+  this->setupStaticFileHeaders(file);
+  this->headers.remove(Headers::Names::TransferEncoding);
+  this->headers.set("Content-Type", file.mimeType);
+  this->headers.set("Content-Length", file.st.st_size);
+  this->sendHeader();
+  if (this->req->getMethod() == Methods::HEAD)
+    return;
+  if (Logger::debug.isEnabled())
+    Logger::debug
+      << "Sending file " << Logger::param(file.path)
+      << " with sendfile, size: " << Logger::param(file.st.st_size) << std::newl;
+  // the write queue shares the cached fd until it is sent
+  Socket::Connection& client = const_cast<Request*>(this->req)->getClient();
+  client.getWriteQueue().pushFile(file.file, 0, file.st.st_size);
+}
+
+void Response::sendCached(const ResponseCache::Entry& entry) {
+  Headers perRequest(this->headers.getArena());
+  static const Headers::Names::Name names[] = {
+    Headers::Names::Date, Headers::Names::Connection, Headers::Names::KeepAlive
+  };
+  for (size_t i = 0; i < sizeof(names) / sizeof(*names); ++i) {
+    const Headers::Entry* entry = this->headers.find(names[i]);
+    if (entry)
+      perRequest.append(entry->name, entry->nameSize, entry->value, entry->valueSize);
   }
+  Socket::Connection& client = const_cast<Request*>(this->req)->getClient();
+  if (Logger::info.isEnabled())
+    Logger::info
+      << "Sending cached response of " << Logger::param(entry.path)
+      << " to: " << Logger::param(client) << std::newl;
+  WriteQueue& queue = client.getWriteQueue();
+  queue.share(entry.response, 0, entry.headerSize);
+  queue.push(perRequest.toString() + "\r\n");
+  if (this->req->getMethod() != Methods::HEAD)
+    queue.share(entry.response, entry.headerSize, entry.size() - entry.headerSize);
+  this->afterSend();
 }
 
 void Response::afterSend() {
   this->sent = true;
-  if (this->headers.has("Connection") && this->headers.get<std::string>("Connection") == "close")
+  const Headers::Entry* connection = this->headers.find(Headers::Names::Connection);
+  if (connection && connection->is("close"))
     const_cast<Request*>(this->req)->getClient().markToClose();
 }
 
@@ -279,6 +349,11 @@ void Response::setupStaticFileHeaders(const std::string& filePath, struct stat*
   this->headers.set("ETag", Utils::httpETag(filePath, fileStat->st_mtime, fileStat->st_size));
 }
 
+void Response::setupStaticFileHeaders(const FileCache::Entry& file) {
+  this->headers.set("Last-Modified", file.lastModified);
+  this->headers.set("ETag", file.etag);
+}
+
 std::ostream& HTTP::operator<<(std::ostream& os, const Response& res) {
   os << "Response(" << res.getStatus() << ", " << res.getStatusMessage() << "):" << std::newl
     << "Headers: " << std::newl << res.getHeaders() << std::newl;
@@ -0,0 +1,123 @@
+#include "http/ResponseCache.hpp"
+#include "http/Response.hpp"
+#include <utils/misc.hpp>
+#include <utils/Logger.hpp>
+#include <Settings.hpp>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+
+using HTTP::ResponseCache;
+using HTTP::Headers;
+using Socket::WriteQueue;
+
+static Settings* settings = Instance::Get<Settings>();
+
+ResponseCache::ResponseCache(uint64_t maxFileSize, uint64_t maxMemory)
+  : lru(), entries(), maxFileSize(maxFileSize), maxMemory(maxMemory), memory(0) {}
+
+ResponseCache::~ResponseCache() {
+  this->clear();
+}
+
+const ResponseCache::Entry* ResponseCache::get(const FileCache::Entry& file, const Response& res) {
+  std::map<std::string, List::iterator>::iterator it = this->entries.find(file.path);
+  if (it != this->entries.end()) {
+    const Entry& entry = **it->second;
+    if (
+      entry.st.st_ino == file.st.st_ino &&
+      entry.st.st_dev == file.st.st_dev &&
+      entry.st.st_mtime == file.st.st_mtime &&
+      entry.st.st_mtim.tv_nsec == file.st.st_mtim.tv_nsec &&
+      entry.st.st_size == file.st.st_size
+      ) {
+      this->lru.splice(this->lru.begin(), this->lru, it->second);
+      return &entry;
+    }
+    this->evict(it->second);
+  }
+  if (static_cast<uint64_t>(file.st.st_size) > this->maxFileSize)
+    return NULL;
+  Entry* entry = this->load(file, res);
+  if (!entry)
+    return NULL;
+  if (entry->size() > this->maxMemory) {
+    entry->response->release();
+    delete entry;
+    return NULL;
+  }
+  while (!this->lru.empty() && this->memory + entry->size() > this->maxMemory)
+    this->evict(--this->lru.end());
+  this->memory += entry->size();
+  this->lru.push_front(entry);
+  this->entries.insert(std::make_pair(entry->path, this->lru.begin()));
+  return entry;
+}
+
+void ResponseCache::invalidate(const std::string& path) {
+  std::map<std::string, List::iterator>::iterator it = this->entries.find(path);
+  if (it != this->entries.end())
+    this->evict(it->second);
+}
+
+void ResponseCache::clear() {
+  while (!this->lru.empty())
+    this->evict(this->lru.begin());
+}
+
+ResponseCache::Entry* ResponseCache::load(const FileCache::Entry& file, const Response& res) {
+  // per request headers are added on each hit instead
+  Headers headers = res.getHeaders();
+  headers.remove(Headers::Names::Date);
+  headers.remove(Headers::Names::Connection);
+  headers.remove(Headers::Names::KeepAlive);
+  headers.remove(Headers::Names::TransferEncoding);
+  headers.set("Last-Modified", file.lastModified);
+  headers.set("ETag", file.etag);
+  headers.set("Content-Type", file.mimeType);
+  headers.set("Content-Length", file.st.st_size);
+  std::stringstream ss;
+  ss << "HTTP/1.1 200 " << settings->httpStatusCode(200) << "\r\n" << headers;
+  const std::string header = ss.str();
+
+  WriteQueue::SharedBuffer* response = new WriteQueue::SharedBuffer();
+  ByteStream& data = response->get();
+  data.put(header);
+  data.resize(header.size() + file.st.st_size);
+  uint64_t read = 0;
+  while (read < static_cast<uint64_t>(file.st.st_size)) {
+    const ssize_t n = ::pread(
+      file.file->get(), data.data() + header.size() + read,
+      file.st.st_size - read, read
+    );
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      Logger::warning
+        << "Could not cache response of " << Logger::param(file.path)
+        << ": " << Logger::param(n == 0 ? "file shrank" : strerror(errno)) << std::newl;
+      response->release();
+      return NULL;
+    }
+    read += n;
+  }
+  Entry* entry = new Entry();
+  entry->path = file.path;
+  entry->st = file.st;
+  entry->response = response;
+  entry->headerSize = header.size();
+  Logger::debug
+    << "Cached response of " << Logger::param(file.path)
+    << " with size " << Logger::param(entry->size()) << std::newl;
+  return entry;
+}
+
+void ResponseCache::evict(List::iterator it) {
+  Entry* entry = *it;
+  this->memory -= entry->size();
+  this->entries.erase(entry->path);
+  this->lru.erase(it);
+  // write queues still sending it keep the buffer alive
+  entry->response->release();
+  delete entry;
+}
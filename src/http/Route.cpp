@@ -2,6 +2,7 @@
 #include "http/ServerConfiguration.hpp"
 #include <Settings.hpp>
 #include <utils/Logger.hpp>
+#include <cstdlib>
 
 using HTTP::Route;
 
@@ -9,7 +10,11 @@ static const Settings* settings = Instance::Get<Settings>();
 
 Route::Route(const ServerConfiguration* server, const YAML::Node& node) :
   server(server),
-  node(node) {}
+  node(node),
+  uri(),
+  methods(0),
+  maxBodySize(0),
+  errorPages() {}
 
 Route::~Route() {
   for (uint32_t i = 0; i < this->modules.size(); ++i)
@@ -18,7 +23,11 @@ Route::~Route() {
 
 Route::Route(const Route& other) :
   server(other.server),
-  node(other.node) {}
+  node(other.node),
+  uri(other.uri),
+  methods(other.methods),
+  maxBodySize(other.maxBodySize),
+  errorPages(other.errorPages) {}
 
 void Route::init(bool injectMethods /* = true */) {
   Logger::debug
@@ -35,6 +44,7 @@ void Route::init(bool injectMethods /* = true */) {
     else
       settings.insert(YAML::Node::NewNull("methods"));
   }
+  this->compileSettings();
   if (injectMethods)
     this->server->getDefaultRoute()->inheritDefaultModules(this);
   if (this->node.has("modules"))
@@ -42,54 +52,54 @@ void Route::init(bool injectMethods /* = true */) {
       this->initModule(this->node["modules"][i]);
 }
 
-bool Route::hasErrorPage(int code) const {
-  const YAML::Node& settings = this->getSettings();
-  if (!settings.has("error_pages") || !settings["error_pages"].is<YAML::Types::Map>()) {
-    const Route* defaultRoute = this->server->getDefaultRoute();
-    if (defaultRoute == this || !defaultRoute)
-      return false;
-    return defaultRoute->hasErrorPage(code);
-  }
-  return settings["error_pages"].has(Utils::toString(code));
-}
+void Route::compileSettings() {
+  const YAML::Node& routeSettings = this->getSettings();
+  // unset while the default route itself is compiled
+  const Route* defaultRoute = this->server->getDefaultRoute();
+  if (defaultRoute == this)
+    defaultRoute = NULL;
+  this->uri = this->node.has("uri") ? this->node["uri"].getValue() : "";
 
-const std::string& Route::getErrorPage(int code) const {
-  const YAML::Node& settings = this->getSettings();
-  if (!this->hasErrorPage(code))
-    throw std::runtime_error("No error page for code " + Utils::toString(code));
-  if (!settings.has("error_pages")) {
-    const Route* defaultRoute = this->server->getDefaultRoute();
-    if (defaultRoute == this || !defaultRoute)
-      throw std::runtime_error("No error page for code " + Utils::toString(code));
-    return defaultRoute->getErrorPage(code);
+  const YAML::Node& methods = routeSettings["methods"];
+  if (!methods.is<YAML::Types::Sequence>())
+    this->methods = ~0u;
+  else {
+    this->methods = defaultRoute ? defaultRoute->methods : 0;
+    for (size_t i = 0; i < methods.size(); ++i) {
+      const Methods::Method method = Methods::FromString(methods[i].getValue());
+      if (method != Methods::UNK)
+        this->methods |= Methods::ToBit(method);
+    }
   }
-  return settings["error_pages"][Utils::toString(code)].getValue();
-}
 
-uint32_t Route::getMaxBodySize() const {
-  const YAML::Node& routeSettings = this->getSettings();
-  if (!routeSettings.has("max_body_size")) {
-    const Route* defaultRoute = this->server->getDefaultRoute();
-    if (defaultRoute == this || !defaultRoute)
-      return settings->get<uint32_t>("http.max_body_size");
-    return defaultRoute->getMaxBodySize();
+  if (routeSettings.has("max_body_size"))
+    this->maxBodySize = routeSettings["max_body_size"].as<uint32_t>();
+  else
+    this->maxBodySize = defaultRoute ? defaultRoute->maxBodySize : settings->getSnapshot().maxBodySize;
+
+  this->errorPages.clear();
+  if (!routeSettings.has("error_pages") || !routeSettings["error_pages"].is<YAML::Types::Map>()) {
+    if (defaultRoute)
+      this->errorPages = defaultRoute->errorPages;
+    return;
+  }
+  const YAML::Node& errorPages = routeSettings["error_pages"];
+  for (
+    YAML::Node::map_const_iterator it = errorPages.begin<YAML::Node::Map>();
+    it != errorPages.end<YAML::Node::Map>();
+    ++it
+    ) {
+    if (!Utils::isInteger(it->first, true))
+      throw std::runtime_error("Invalid error page code: " + it->first);
+    this->errorPages[std::atoi(it->first.c_str())] = it->second.getValue();
   }
-  return routeSettings["max_body_size"].as<uint32_t>();
 }
 
-bool Route::isMethodAllowed(Methods::Method method) const {
-  const YAML::Node& methods = this->getSettings()["methods"];
-  if (!methods.is<YAML::Types::Sequence>())
-    return true;
-  const std::string methodStr = Methods::ToString(method);
-  for (size_t i = 0; i < methods.size(); ++i) {
-    if (methods[i].getValue() == methodStr)
-      return true;
-  }
-  const Route* defaultRoute = this->server->getDefaultRoute();
-  if (defaultRoute == this || !defaultRoute)
-    return false;
-  return defaultRoute->isMethodAllowed(method);
+const std::string& Route::getErrorPage(int code) const {
+  const std::map<int, std::string>::const_iterator it = this->errorPages.find(code);
+  if (it == this->errorPages.end())
+    throw std::runtime_error("No error page for code " + Utils::toString(code));
+  return it->second;
 }
 
 std::ostream& HTTP::operator<<(std::ostream& os, const Route& route) {
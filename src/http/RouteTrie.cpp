@@ -0,0 +1,104 @@
+#include "http/RouteTrie.hpp"
+#include <cstring>
+
+using HTTP::RouteTrie;
+
+static inline bool before(char a, char b) {
+  return static_cast<unsigned char>(a) < static_cast<unsigned char>(b);
+}
+
+RouteTrie::Node::Node(const std::string& label, const Route* route /* = NULL */)
+  : label(label), route(route), children() {}
+
+RouteTrie::Node::~Node() {
+  for (size_t i = 0; i < this->children.size(); ++i)
+    delete this->children[i];
+}
+
+RouteTrie::Node* RouteTrie::Node::child(char c) const {
+  size_t low = 0;
+  size_t high = this->children.size();
+  while (low < high) {
+    const size_t mid = low + (high - low) / 2;
+    const char first = this->children[mid]->label[0];
+    if (first == c)
+      return this->children[mid];
+    if (before(first, c))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return NULL;
+}
+
+void RouteTrie::Node::addChild(Node* node) {
+  std::vector<Node*>::iterator it = this->children.begin();
+  while (it != this->children.end() && before((*it)->label[0], node->label[0]))
+    ++it;
+  this->children.insert(it, node);
+}
+
+RouteTrie::RouteTrie() : root(new Node("")) {}
+
+RouteTrie::~RouteTrie() {
+  delete this->root;
+}
+
+bool RouteTrie::insert(const std::string& uri, const Route* route) {
+  Node* node = this->root;
+  size_t i = 0;
+  while (i < uri.size()) {
+    Node* child = node->child(uri[i]);
+    if (!child) {
+      node->addChild(new Node(uri.substr(i), route));
+      return true;
+    }
+    const std::string& label = child->label;
+    size_t common = 0;
+    while (common < label.size() && i + common < uri.size() && label[common] == uri[i + common])
+      common++;
+    // uri diverges (or ends) midway through the edge, split it
+    if (common < label.size()) {
+      Node* split = new Node(label.substr(0, common));
+      child->label.erase(0, common);
+      for (size_t j = 0; j < node->children.size(); ++j)
+        if (node->children[j] == child)
+          node->children[j] = split;
+      split->addChild(child);
+      child = split;
+    }
+    i += common;
+    node = child;
+  }
+  if (node->route)
+    return false;
+  node->route = route;
+  return true;
+}
+
+const HTTP::Route* RouteTrie::find(const char* path, size_t size) const {
+  const Node* node = this->root;
+  const Route* nearest = NULL;
+  size_t i = 0;
+  while (true) {
+    // only whole segments match, a route ending with '/' is one already (i.e. /)
+    if (node->route && (i == size || path[i] == '/' || (i > 0 && path[i - 1] == '/')))
+      nearest = node->route;
+    if (i == size)
+      break;
+    const Node* child = node->child(path[i]);
+    if (!child)
+      break;
+    const std::string& label = child->label;
+    if (size - i < label.size() || std::memcmp(path + i, label.data(), label.size()) != 0)
+      break;
+    i += label.size();
+    node = child;
+  }
+  return nearest;
+}
+
+void RouteTrie::clear() {
+  delete this->root;
+  this->root = new Node("");
+}
@@ -8,7 +8,8 @@
 using namespace HTTP;
 
 ServerConfiguration::ServerConfiguration(const YAML::Node& config)
-  : config(config), hosts(), names(), defaultHost(false), defaultRoute(NULL), routes() {}
+  : config(config), hosts(), names(), defaultHost(false), defaultRoute(NULL), routes(), routeTrie(),
+  keepAliveTimeout(0), maxRequestsPerConnection(0) {}
 
 ServerConfiguration::~ServerConfiguration() {
   if (this->defaultRoute)
@@ -22,7 +23,10 @@ ServerConfiguration::ServerConfiguration(const ServerConfiguration& other)
   hosts(other.hosts),
   names(other.names),
   defaultHost(other.defaultHost),
-  defaultRoute(other.defaultRoute) {
+  defaultRoute(other.defaultRoute),
+  routeTrie(),
+  keepAliveTimeout(other.keepAliveTimeout),
+  maxRequestsPerConnection(other.maxRequestsPerConnection) {
   for (std::map<std::string, const Route*>::iterator it = this->routes.begin(); it != this->routes.end(); ++it)
     delete it->second;
   this->routes.clear();
@@ -30,26 +34,11 @@ ServerConfiguration::ServerConfiguration(const ServerConfiguration& other)
     this->routes[it->first] = new Route(*it->second);
     if (this->routes[it->first])
       const_cast<Route*>(this->routes[it->first])->init();
+    this->routeTrie.insert(it->first, this->routes[it->first]);
   }
 }
 
 
-bool ServerConfiguration::match(const Request& req) const {
-  ServerManager* serverManager = Instance::Get<ServerManager>();
-  Socket::Server& server = serverManager->getServer(req.getClient().getServerSock());
-  if (!this->hasHost(server))
-    return false;
-  std::string host = req.getHost();
-  if (host.empty())
-    return false;
-  uint64_t pos;
-  if ((pos = host.find(':')) != std::string::npos)
-    host.erase(pos, host.size() - pos);
-  if (!this->hasName(host))
-    return false;
-  return true;
-}
-
 const std::vector<Socket::Host>& ServerConfiguration::getHosts() const {
   return this->hosts;
 }
@@ -77,7 +66,7 @@ void ServerConfiguration::setAsDefaultHost(bool state /* = true */) {
 int ServerConfiguration::getMaxConnections() const {
   const YAML::Node& settings = this->getSettings();
   if (!settings.has("max_connections"))
-    return Instance::Get<Settings>()->get<int>("socket.max_connections");
+    return Instance::Get<Settings>()->getSnapshot().maxConnections;
   return settings["max_connections"].as<int>();
 }
 
@@ -88,40 +77,38 @@ const Route* ServerConfiguration::getRoute(const std::string& path) const {
 }
 
 const Route* ServerConfiguration::getNearestRoute(const std::string& path) const {
-  std::string currentPath = path;
-  while (currentPath != "/" && currentPath.length() > 0) {
-    if (this->routes.count(currentPath) == 0) {
-      std::string dir = Utils::dirname(currentPath);
-      if (dir == currentPath)
-        break;
-      currentPath = dir;
-    }
-    else
-      return this->routes.at(currentPath);
-  }
-  if (this->getRoute(currentPath))
-    return this->getRoute(currentPath);
-  return NULL;
+  return this->routeTrie.find(path);
 }
 
 const Routes::Default* ServerConfiguration::getDefaultRoute() const {
   return this->defaultRoute;
 }
 
+uint32_t ServerConfiguration::getMaxBodySize(const std::string& path) const {
+  const Route* route = this->getNearestRoute(path);
+  if (!route)
+    return this->getDefaultRoute()->getMaxBodySize();
+  return route->getMaxBodySize();
+}
+
 void ServerConfiguration::handleRequest(const Request& req, Response& res) const {
+  // the client now follows this server's keep-alive limits
+  Socket::Connection& client = const_cast<Request&>(req).getClient();
+  client.setTimeout(this->getKeepAliveTimeout());
+  client.setMaxRequests(this->getMaxRequestsPerConnection());
+  res.setupConnectionHeaders();
   res.setRoute(this->getDefaultRoute());
   const Route* route = this->getNearestRoute(req.getPath());
   if (!route)
     return res.status(404).send();
-  Logger::debug
-    << "Handling request for " << Logger::param(req.getPath())
-    << " with route " << Logger::param(*route)
-    << std::newl;
+  if (Logger::debug.isEnabled())
+    Logger::debug
+      << "Handling request for " << Logger::param(req.getPath())
+      << " with route " << Logger::param(*route)
+      << std::newl;
   res.setRoute(route);
   if (!route->isMethodAllowed(req.getMethod()))
     return res.status(405).send();
-  if (route->getMaxBodySize() > 0 && req.getRawBody().size() > route->getMaxBodySize())
-    return res.status(413).send();
   try {
     route->handle(req, res);
   }
@@ -140,6 +127,11 @@ void ServerConfiguration::validate() {
     throw std::runtime_error("No names defined");
   if (!this->defaultRoute)
     throw std::runtime_error("Default Route could not be created");
+  const YAML::Node& settings = this->getSettings();
+  if (settings.has("keep_alive_timeout") && (!settings["keep_alive_timeout"].is<int>() || settings["keep_alive_timeout"].as<int>() < 0))
+    throw std::runtime_error("keep_alive_timeout must be a non-negative integer");
+  if (settings.has("max_requests_per_connection") && (!settings["max_requests_per_connection"].is<int>() || settings["max_requests_per_connection"].as<int>() < 0))
+    throw std::runtime_error("max_requests_per_connection must be a non-negative integer");
 }
 
 void ServerConfiguration::init() {
@@ -156,6 +148,13 @@ void ServerConfiguration::init() {
     this->defaultHost = true;
   this->defaultRoute = new Routes::Default(this->config, this);
   this->validate();
+  const YAML::Node& settings = this->getSettings();
+  this->keepAliveTimeout = settings.has("keep_alive_timeout")
+    ? settings["keep_alive_timeout"].as<int>()
+    : Instance::Get<Settings>()->getSnapshot().keepAliveTimeout;
+  this->maxRequestsPerConnection = settings.has("max_requests_per_connection")
+    ? settings["max_requests_per_connection"].as<uint32_t>()
+    : Instance::Get<Settings>()->getSnapshot().maxRequestsPerConnection;
   if (this->config.has("routes"))
     this->initRoutes();
 }
@@ -263,6 +262,7 @@ void ServerConfiguration::addRoute(const std::string& path, const Route* route)
   this->routes.insert(
     std::make_pair(path, route)
   );
+  this->routeTrie.insert(path, route);
   Logger::info
     << "Added route "
     << Logger::param(path)
@@ -1,10 +1,13 @@
 #include "http/ServerManager.hpp"
 #include "http/ServerConfiguration.hpp"
+#include <Settings.hpp>
 #include <csignal>
+#include <cstring>
+#include <sys/wait.h>
 
 using namespace HTTP;
 
-ServerManager::ServerManager() : WebSocket() {
+ServerManager::ServerManager() : WebSocket(), env(NULL), envSize(0), supervisor(false), workerId(0) {
   std::signal(SIGINT, ServerManager::onSIGINT);
 }
 ServerManager::~ServerManager() {
@@ -26,9 +29,14 @@ bool ServerManager::loadConfig(const std::string& path) {
     for (size_t i = 0; i < this->servers.size(); i++) {
       ServerConfiguration* server = this->servers[i];
       const std::vector<Socket::Host>& hosts = server->getHosts();
-      for (uint64_t i = 0; i < hosts.size(); i++)
-        if (!this->defaultServers.count(hosts[i]) || server->isDefaultHost())
-          this->defaultServers[hosts[i]] = server;
+      const std::vector<std::string>& names = server->getNames();
+      for (uint64_t i = 0; i < hosts.size(); i++) {
+        if (!this->virtualHosts.getDefault(hosts[i]) || server->isDefaultHost())
+          this->virtualHosts.setDefault(hosts[i], server);
+        // the first server listing a name keeps it, as when they were matched in order
+        for (size_t j = 0; j < names.size(); j++)
+          this->virtualHosts.insert(hosts[i], names[j], server);
+      }
     }
     // check for duplicated server names
     for (size_t i = 0; i < this->servers.size(); i++) {
@@ -70,17 +78,21 @@ void ServerManager::addServer(const YAML::Node& node) {
 }
 
 ServerConfiguration* ServerManager::selectServer(const Request& req) const {
-  for (size_t i = 0; i < this->servers.size(); i++) {
-    if (this->servers[i]->match(req))
-      return this->servers[i];
+  const Socket::Server& listen = req.getServer();
+  const Headers::Entry* host = req.getHeaders().find(Headers::Names::Host);
+  if (host) {
+    // without the port
+    const void* colon = std::memchr(host->value, ':', host->valueSize);
+    const size_t size = colon ? static_cast<const char*>(colon) - host->value : host->valueSize;
+    ServerConfiguration* server = this->virtualHosts.find(listen, host->value, size);
+    if (server)
+      return server;
   }
-  return this->getDefaultServer(req.getServer());
+  return this->getDefaultServer(listen);
 }
 
-ServerConfiguration* ServerManager::getDefaultServer(const Socket::Host host) const {
-  if (this->defaultServers.count(host) > 0)
-    return this->defaultServers.at(host);
-  return nullptr;
+ServerConfiguration* ServerManager::getDefaultServer(const Socket::Host& host) const {
+  return this->virtualHosts.getDefault(host);
 }
 
 void ServerManager::onRequest(const Request& req, Response& res) {
@@ -92,6 +104,70 @@ void ServerManager::onRequest(const Request& req, Response& res) {
   server->handleRequest(req, res);
 }
 
+size_t ServerManager::getMaxBodySize(const Request& req) const {
+  const ServerConfiguration* server = this->selectServer(req);
+  if (!server)
+    return Instance::Get<Settings>()->getSnapshot().maxBodySize;
+  return server->getMaxBodySize(req.getPath());
+}
+
+void ServerManager::spawnWorkers() {
+  const int count = Instance::Get<Settings>()->getSnapshot().workers;
+  if (count <= 1)
+    return;
+  this->setReusePort(true);
+  for (int i = 0; i < count; i++) {
+    const pid_t pid = fork();
+    if (pid == -1) {
+      if (this->workers.empty())
+        throw std::runtime_error("Failed to fork worker " + Utils::toString(i));
+      Logger::error
+        << "Failed to fork worker " << Logger::param(i) << ": " << Logger::errstr()
+        << ", running with " << Logger::param(this->workers.size()) << " workers" << std::newl;
+      break;
+    }
+    if (pid == 0) {
+      this->workers.clear();
+      this->workerId = i;
+      this->reset();
+      Logger::info
+        << "Worker " << Logger::param(i)
+        << " started with pid " << Logger::param(getpid()) << std::newl;
+      return;
+    }
+    this->workers.push_back(pid);
+  }
+  this->supervisor = true;
+}
+
+int ServerManager::waitWorkers() {
+  int exitCode = 0;
+  while (!this->workers.empty()) {
+    int status;
+    const pid_t pid = waitpid(-1, &status, 0);
+    if (pid == -1) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    std::vector<pid_t>::iterator it = std::find(this->workers.begin(), this->workers.end(), pid);
+    if (it == this->workers.end())
+      continue;
+    this->workers.erase(it);
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+      Logger::info
+        << "Worker with pid " << Logger::param(pid) << " exited" << std::newl;
+      continue;
+    }
+    exitCode = 1;
+    Logger::error
+      << "Worker with pid " << Logger::param(pid) << " exited abnormally "
+      << "(status " << Logger::param(WIFEXITED(status) ? WEXITSTATUS(status) : WTERMSIG(status)) << ")"
+      << std::newl;
+  }
+  return exitCode;
+}
+
 void ServerManager::bindServers() {
   std::vector<Socket::ListenAddress> listenAddresses;
   for (size_t i = 0; i < this->servers.size(); i++) {
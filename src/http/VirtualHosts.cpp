@@ -0,0 +1,105 @@
+#include "http/VirtualHosts.hpp"
+#include <utils/misc.hpp>
+#include <strings.h>
+#include <cctype>
+
+using HTTP::VirtualHosts;
+using HTTP::ServerConfiguration;
+
+static const size_t initialSlots = 16;
+
+static inline uint32_t fnv1a(uint32_t hash, unsigned char c) {
+  return (hash ^ c) * 16777619u;
+}
+
+VirtualHosts::Slot::Slot() : hash(0), host(), name(), server(NULL) {}
+
+VirtualHosts::VirtualHosts() : slots(initialSlots), count(0) {}
+
+VirtualHosts::~VirtualHosts() {}
+
+uint32_t VirtualHosts::Hash(const Socket::Host& host, const char* name, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < host.address.size(); ++i)
+    hash = fnv1a(hash, host.address[i]);
+  for (size_t i = 0; i < sizeof(host.port); ++i)
+    hash = fnv1a(hash, (host.port >> (i * 8)) & 0xff);
+  for (size_t i = 0; i < size; ++i)
+    hash = fnv1a(hash, std::tolower(static_cast<unsigned char>(name[i])));
+  return hash;
+}
+
+size_t VirtualHosts::probe(uint32_t hash, const Socket::Host& host, const char* name, size_t size) const {
+  const size_t mask = this->slots.size() - 1;
+  size_t i = hash & mask;
+  while (true) {
+    const Slot& slot = this->slots[i];
+    if (!slot.server)
+      return i;
+    if (
+      slot.hash == hash && slot.name.size() == size && slot.host == host
+      && strncasecmp(slot.name.data(), name, size) == 0
+    )
+      return i;
+    i = (i + 1) & mask;
+  }
+}
+
+VirtualHosts::Slot& VirtualHosts::at(const Socket::Host& host, const std::string& name) {
+  if ((this->count + 1) * 2 > this->slots.size())
+    this->grow();
+  const uint32_t hash = VirtualHosts::Hash(host, name.data(), name.size());
+  Slot& slot = this->slots[this->probe(hash, host, name.data(), name.size())];
+  if (!slot.server) {
+    slot.hash = hash;
+    slot.host = host;
+    slot.name = name;
+    Utils::toLowercase(slot.name);
+  }
+  return slot;
+}
+
+void VirtualHosts::grow() {
+  std::vector<Slot> old(this->slots.size() * 2);
+  old.swap(this->slots);
+  for (size_t i = 0; i < old.size(); ++i) {
+    if (!old[i].server)
+      continue;
+    const Slot& slot = old[i];
+    this->slots[this->probe(slot.hash, slot.host, slot.name.data(), slot.name.size())] = slot;
+  }
+}
+
+bool VirtualHosts::insert(const Socket::Host& host, const std::string& name, ServerConfiguration* server) {
+  Slot& slot = this->at(host, name);
+  if (slot.server)
+    return false;
+  slot.server = server;
+  this->count++;
+  return true;
+}
+
+void VirtualHosts::setDefault(const Socket::Host& host, ServerConfiguration* server) {
+  Slot& slot = this->at(host, "");
+  if (!slot.server)
+    this->count++;
+  slot.server = server;
+}
+
+ServerConfiguration* VirtualHosts::find(const Socket::Host& host, const char* name, size_t size) const {
+  // an empty name would be the default's slot
+  if (size == 0)
+    return NULL;
+  const uint32_t hash = VirtualHosts::Hash(host, name, size);
+  return this->slots[this->probe(hash, host, name, size)].server;
+}
+
+ServerConfiguration* VirtualHosts::getDefault(const Socket::Host& host) const {
+  const uint32_t hash = VirtualHosts::Hash(host, "", 0);
+  return this->slots[this->probe(hash, host, "", 0)].server;
+}
+
+void VirtualHosts::clear() {
+  std::vector<Slot>(initialSlots).swap(this->slots);
+  this->count = 0;
+}
@@ -1,25 +1,36 @@
 #include "http/WebSocket.hpp"
+#include "http/FastCGI.hpp"
 #include <Settings.hpp>
 #include <utils/misc.hpp>
 #include <utils/Logger.hpp>
 #include <http/utils.hpp>
 #include <http/ErrorCodes.hpp>
+#include <cctype>
 
 using namespace HTTP;
 
 typedef HTTP::PendingRequest::States ReqStates;
+typedef HTTP::RequestParser::Results ParseResults;
 
 static Settings* settings = Instance::Get<Settings>();
 
 WebSocket::WebSocket()
-  : Socket::Parallel(settings->get<int>("socket.keep_alive_timeout")) {}
+  : Socket::Parallel(settings->getSnapshot().keepAliveTimeout), submittingClient(-1) {}
 
-WebSocket::~WebSocket() {}
+WebSocket::~WebSocket() {
+  for (std::map<pid_t, PendingResponse*>::iterator it = this->pendingCGIResponses.begin(); it != this->pendingCGIResponses.end(); ++it)
+    delete it->second;
+  for (std::map<std::string, FastCGI::Pool*>::iterator it = this->fastCGIPools.begin(); it != this->fastCGIPools.end(); ++it)
+    delete it->second;
+}
 
 void WebSocket::onClientConnect(const Socket::Connection&) {}
 
 bool WebSocket::onClientDisconnect(Socket::Connection& sock) {
-  if (this->pendingRequests.count(sock) > 0 && sock.hasTimedOut()) {
+  // idle keep-alive connections are just closed, only a started request gets a 408
+  const bool receiving = this->pendingRequests.count(sock) > 0
+    && (this->pendingRequests.at(sock).getState() != ReqStates::Uri || !sock.getReadBuffer().empty());
+  if (receiving && sock.hasTimedOut()) {
     this->sendBadRequest(sock, ErrorCodes::RequestTimeout, "Client timed out");
     return false;
   }
@@ -27,6 +38,10 @@ bool WebSocket::onClientDisconnect(Socket::Connection& sock) {
     const pid_t pId = this->pendingCGIProcesses.at(sock.getHandle());
     this->kill(this->getProcess(pId), Socket::Process::ExitCodes::ClientTimeout);
   }
+  if (this->pendingFastCGIJobs.count(sock.getHandle()) > 0) {
+    FastCGI::Job* job = this->pendingFastCGIJobs.at(sock.getHandle());
+    job->getPool().cancel(job);
+  }
   this->pendingRequests.erase(sock);
   return true;
 }
@@ -36,181 +51,219 @@ void WebSocket::onClientRead(Socket::Connection& sock) {
 }
 
 void WebSocket::handleClientPacket(Socket::Connection& sock) {
-  if (!this->pendingRequests.count(sock))
+  ByteStream& packet = sock.getReadBuffer();
+  // pipelined requests are handled back to back, their responses are queued in order
+  // responses must not overtake a pending cgi one, the rest waits in the read buffer
+  while (
+    this->pendingCGIProcesses.count(sock.getHandle()) == 0 &&
+    this->pendingFastCGIJobs.count(sock.getHandle()) == 0 &&
+    !sock.shouldCloseOnEmptyWriteBuffer()
+    ) {
+    if (!this->handleRequest(sock, packet) || packet.empty())
+      return;
+  }
+}
+
+bool WebSocket::handleRequest(Socket::Connection& sock, ByteStream& packet) {
+  if (!this->pendingRequests.count(sock)) {
     this->pendingRequests.insert(std::make_pair(sock, PendingRequest(this, &sock)));
+    // puts its headers in the connection's arena
+    this->pendingRequests.at(sock).reset();
+  }
   PendingRequest& pendingRequest = this->pendingRequests.at(sock);
-  ByteStream& packet = sock.getReadBuffer();
-  HTTPStream stream(packet);
-  pendingRequest.handlePacket(stream);
-  while (pendingRequest.getState() != ReqStates::Done) {
-    if (!pendingRequest.isParsingBody()) {
-      std::string line;
-      if (!stream.getline(line))
-        break;
+  ParseResults::Result result = ParseResults::Done;
+  try {
+    while (result == ParseResults::Done && pendingRequest.getState() != ReqStates::Done) {
+      if (pendingRequest.isParsingHead())
+        result = this->parseHead(sock, pendingRequest, packet);
+      else
+        result = this->parseBody(sock, pendingRequest, packet);
+    }
+  }
+  catch (const std::exception& e) {
+    // i.e. the body couldn't be spilled to disk
+    this->sendBadRequest(sock, ErrorCodes::InternalServerError, e.what());
+    return false;
+  }
+  // on errors, a response was already sent & the request dropped
+  if (result == ParseResults::Error || pendingRequest.getState() != ReqStates::Done)
+    return false;
+  // handle multiform-data
+  // pendingRequest.handleMultiformData();
+  pendingRequest.parseBodyParams();
+  {
+    Response res(pendingRequest, NULL, sock.getArena());
+    if (Logger::info.isEnabled())
+      Logger::info
+        << "New request from " << Logger::param(sock) << ": " << std::newl
+        << Logger::param(static_cast<const Request&>(pendingRequest));
+    this->setClientToWrite(sock);
+    this->onRequest(pendingRequest, res);
+  }
+  // anything that outlives the request (i.e. cgi responses) made its own copy
+  pendingRequest.reset();
+  return true;
+}
+
+ParseResults::Result WebSocket::parseHead(Socket::Connection& sock, PendingRequest& pendingRequest, ByteStream& packet) {
+  RequestParser& parser = pendingRequest.getParser();
+  switch (parser.parse(packet)) {
+    case ParseResults::Error:
+      this->sendBadRequest(sock, parser.getErrorCode(), parser.getError());
+      return ParseResults::Error;
+    case ParseResults::Incomplete:
+      if (parser.getState() == RequestParser::States::Headers)
+        pendingRequest.setState(ReqStates::Headers);
+      return ParseResults::Incomplete;
+    default:
+      break;
+  }
+  // the head is complete, copy it out of the read buffer once
+  const char* data = reinterpret_cast<const char*>(packet.data());
+  pendingRequest.setMethod(parser.getMethod());
+  pendingRequest.setPath(data + parser.getTarget().offset, parser.getTarget().size);
+  pendingRequest.setProtocol(RequestParser::ToString(packet, parser.getProtocol()));
+  if (Logger::debug.isEnabled())
+    Logger::debug
+      << "method: " << Logger::param(Methods::ToString(pendingRequest.getMethod()))
+      << ", path: " << Logger::param(pendingRequest.getPath())
+      << ", protocol: " << Logger::param(pendingRequest.Request::getProtocol())
+      << std::newl;
+  Headers& headers = pendingRequest.getHeaders();
+  const std::vector<RequestParser::Header>& fields = parser.getHeaders();
+  for (size_t i = 0; i < fields.size(); ++i) {
+    const RequestParser::Span& name = fields[i].name;
+    const RequestParser::Span& value = fields[i].value;
+    headers.append(data + name.offset, name.size, data + value.offset, value.size);
+    if (Logger::debug.isEnabled())
       Logger::debug
-        << "Parsing line: " << Logger::param(line)
-        << " from " << Logger::param(sock)
-        << " in state " << Logger::param(ReqStates::ToString(pendingRequest.getState()))
+        << "new header variable: " << Logger::param(RequestParser::ToString(packet, name))
+        << " = " << Logger::param(RequestParser::ToString(packet, value))
         << std::newl;
-      switch (pendingRequest.getState())
-      {
-      case ReqStates::Uri: {
+  }
+  packet.ignore(parser.getHeadSize());
+  parser.reset();
+  sock.countRequest();
+  // mandatory since HTTP/1.1 (RFC 9112 3.2), HTTP/1.0 requests without one go to the default server
+  if (pendingRequest.Request::getProtocol() == "HTTP/1.1" && !headers.has(Headers::Names::Host)) {
+    this->sendBadRequest(sock, ErrorCodes::BadRequest, "Missing Host header");
+    return ParseResults::Error;
+  }
+  const Headers::Entry* transferEncoding = headers.find(Headers::Names::TransferEncoding);
+  const bool hasContentLength = headers.has(Headers::Names::ContentLength);
+  uint64_t contentLength = 0;
+  if (hasContentLength && !headers.getNumber(Headers::Names::ContentLength, contentLength)) {
+    this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid Content-Length");
+    return ParseResults::Error;
+  }
+  if (transferEncoding && transferEncoding->is("chunked"))
+    pendingRequest.setState(ReqStates::BodyChunkSize);
+  else if (!hasContentLength && !transferEncoding && pendingRequest.getMethod() > Methods::DELETE) {
+    this->sendBadRequest(sock, ErrorCodes::LengthRequired, "Missing Content-Length");
+    return ParseResults::Error;
+  }
+  else if (contentLength == 0)
+    pendingRequest.setState(ReqStates::Done);
+  else
+    pendingRequest.setState(ReqStates::Body);
+  // the route's limit is known before reading any of the body
+  if (pendingRequest.getState() != ReqStates::Done) {
+    pendingRequest.maxBodySize = this->getMaxBodySize(pendingRequest);
+    const size_t maxBodySize = pendingRequest.maxBodySize;
+    if (pendingRequest.getState() == ReqStates::Body && maxBodySize > 0 && pendingRequest.getContentLength() > maxBodySize) {
+      this->sendBadRequest(sock, ErrorCodes::PayloadTooLarge, "Content-Length over " + Utils::toString(maxBodySize) + " bytes");
+      return ParseResults::Error;
+    }
+  }
+  if (pendingRequest.isExpecting()) {
+    Response res(pendingRequest, NULL);
+    Logger::info
+      << "New request expecting from " << Logger::param(sock) << ": " << std::newl
+      << Logger::param(static_cast<const Request&>(pendingRequest));
+    this->setClientToWrite(sock);
+    this->onRequest(pendingRequest, res);
+    if (res.getStatus() != ErrorCodes::Continue) {
+      this->pendingRequests.erase(sock);
+      return ParseResults::Error;
+    }
+    headers.remove(Headers::Names::Expect);
+  }
+  return ParseResults::Done;
+}
 
-        std::vector<std::string> parts = Utils::split(line, " ");
-        if (parts.size() != 3)
-          return this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid URI " + line + " (invalid parts)");
-        { // Handle Method
-          std::string& methodStr = parts[0];
-          const Methods::Method method = Methods::FromString(methodStr);
-          Logger::debug
-            << "method: " << Logger::param(methodStr) << " (" << Logger::param(method) << ")"
-            << std::newl;
-          if (method == Methods::UNK) {
-            // send 501 (Not Implemented)
-            return this->sendBadRequest(sock, ErrorCodes::NotImplemented, "Unknown method " + methodStr);
-          }
-          pendingRequest.setMethod(method);
-        }
-        { // Handle URL
-          std::string& path = parts[1];
-          Logger::debug
-            << "path: " << Logger::param(path)
-            << std::newl;
-          if (path.empty() || path[0] != '/' || HTTP::hasDisallowedUriToken(path)) {
-            // send 400 (Bad Request)
-            return this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid URI " + line + " (disallowed token)");
-          }
-          if (path.size() > settings->get<size_t>("http.max_uri_size")) {
-            // send 414 (URI Too Long)
-            return this->sendBadRequest(sock, ErrorCodes::URITooLong, "URI too long " + path);
-          }
-          pendingRequest.setPath(path);
-        }
-        { // Handle Protocol
-          std::string& protocol = parts[2];
-          std::vector<std::string> protocolParts = Utils::split(protocol, "/");
-          if (protocolParts.size() != 2)
-            return this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid protocol " + protocol);
-          pendingRequest.setProtocol(protocol);
-          PendingRequest::Protocol proto = pendingRequest.getProtocol();
-          Logger::debug
-            << "protocol: " << Logger::param(proto.type) << " ("
-            << Logger::param(proto.versionMajor) << "." << Logger::param(proto.versionMinor)
-            << ")" << std::newl;
-          if (proto.type != "HTTP")
-            return this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid protocol " + proto.type);
-          if (proto.versionMajor != 1 || proto.versionMinor != 1)
-            return this->sendBadRequest(sock, ErrorCodes::HTTPVersionNotSupported, "Invalid protocol version " + static_cast<std::string>(proto));
-        }
-        pendingRequest.next();
-        break;
-      }
-      case ReqStates::Headers: {
-        if (line.empty()) {
-          Headers& headers = pendingRequest.getHeaders();
-          if (headers.has("Transfer-Encoding") && headers.get<std::string>("Transfer-Encoding") == "chunked")
-            pendingRequest.state = ReqStates::BodyChunkSize;
-          else if (!headers.has("Content-Length") && !headers.has("Transfer-Encoding") && pendingRequest.getMethod() > Methods::DELETE)
-            return this->sendBadRequest(sock, ErrorCodes::LengthRequired, "Missing Content-Length");
-          else if (!headers.has("Content-Length") || headers.get<size_t>("Content-Length") == 0)
-            pendingRequest.state = ReqStates::Done;
-          else
-            pendingRequest.state = ReqStates::Body;
-          if (pendingRequest.isExpecting()) {
-            const Request req(pendingRequest);
-            Response res(req, NULL);
-            Logger::info
-              << "New request expecting from " << Logger::param(sock) << ": " << std::newl
-              << Logger::param(req);
-            this->setClientToWrite(sock);
-            this->onRequest(req, res);
-            if (res.getStatus() != ErrorCodes::Continue) {
-              this->pendingRequests.erase(sock);
-              return;
-            }
-            else
-              headers.remove("Expect");
-          }
-          break;
-        }
-        std::string::size_type sepPos = line.find(':');
-        if (sepPos != std::string::npos) { // handle ':' case
-          if (sepPos == 0 || sepPos == line.size() - 1)
-            return this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid header " + line);
-          std::string key = line.substr(0, sepPos);
-          std::string value = line.substr(sepPos + 1);
-          if (HTTP::hasFieldToken(key))
-            return this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid header " + key);
-          pendingRequest.getHeaders().append(key, value);
-          Logger::debug
-            << "new header variable: " << Logger::param(key) << " = " << Logger::param(value)
-            << std::newl;
-          break;
-        }
-        sepPos = line.find(';');
-        if (sepPos != std::string::npos) { // handle ';' case
-          std::string key = line.substr(0, sepPos);
-          if (HTTP::hasFieldToken(key))
-            return this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid header " + key);
-          pendingRequest.getHeaders().append(key, "");
-          Logger::debug
-            << "new header variable: " << Logger::param(key)
-            << std::newl;
+ParseResults::Result WebSocket::parseBody(Socket::Connection& sock, PendingRequest& pendingRequest, ByteStream& packet) {
+  const size_t maxBodySize = pendingRequest.maxBodySize;
+  switch (pendingRequest.getState()) {
+    case ReqStates::Body: {
+      const size_t contentLength = pendingRequest.getContentLength();
+      const size_t size = std::min<size_t>(packet.size(), contentLength - pendingRequest.getBody().size());
+      pendingRequest.addToBody(packet, size);
+      packet.ignore(size);
+      if (pendingRequest.getBody().size() < contentLength)
+        return ParseResults::Incomplete;
+      pendingRequest.setState(ReqStates::Done);
+      return ParseResults::Done;
+    }
+    case ReqStates::BodyChunkSize: {
+      const uint64_t eol = RequestParser::FindLine(packet, 0);
+      if (eol == RequestParser::npos)
+        return ParseResults::Incomplete;
+      size_t chunkSize = 0;
+      uint64_t i = 0;
+      for (; i + 1 < eol && std::isxdigit(packet[i]); ++i) {
+        if (chunkSize > (static_cast<size_t>(-1) >> 4))
           break;
-        }
-        return this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid header " + line);
+        const int c = std::tolower(packet[i]);
+        chunkSize = (chunkSize << 4) | (std::isdigit(c) ? c - '0' : c - 'a' + 10);
       }
-      case ReqStates::BodyChunkSize: {
-        std::stringstream ss(line);
-        if (!(ss >> std::hex >> pendingRequest.chunkSize))
-          return this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid chunk size " + line);
-        if (pendingRequest.chunkSize == 0) {
-          pendingRequest.state = ReqStates::Done;
-          break;
-        }
-        pendingRequest.next();
-        break;
+      // chunk extensions are ignored
+      if (i == 0 || packet[eol - 1] != '\r' || (i + 1 < eol && packet[i] != ';')) {
+        this->sendBadRequest(sock, ErrorCodes::BadRequest, "Invalid chunk size " + RequestParser::ToString(packet, RequestParser::Span(0, eol)));
+        return ParseResults::Error;
       }
-      default:
-        break;
+      // chunked bodies are cut off as soon as they go over the limit
+      if (maxBodySize > 0 && chunkSize > maxBodySize - pendingRequest.getBody().size()) {
+        this->sendBadRequest(sock, ErrorCodes::PayloadTooLarge, "Chunked body over " + Utils::toString(maxBodySize) + " bytes");
+        return ParseResults::Error;
       }
+      packet.ignore(eol + 1);
+      pendingRequest.chunkSize = chunkSize;
+      pendingRequest.setState(chunkSize == 0 ? ReqStates::BodyTrailers : ReqStates::BodyChunkData);
+      return ParseResults::Done;
     }
-    else {
-      switch (pendingRequest.getState()) {
-        case ReqStates::Body: {
-          size_t size = std::min(packet.size(), pendingRequest.getHeaders().get<size_t>("Content-Length"));
-          packet.resize(size);
-          pendingRequest.addToBody(packet);
-          if (pendingRequest.getBody().size() == pendingRequest.getHeaders().get<size_t>("Content-Length"))
-            pendingRequest.state = ReqStates::Done;
-          break;
-        }
-        case ReqStates::BodyChunkData: {
-          size_t size = std::min(packet.size(), pendingRequest.chunkSize);
-          pendingRequest.chunkData.put(packet, size);
-          if (pendingRequest.chunkData.size() == pendingRequest.chunkSize) {
-            pendingRequest.addToBody(pendingRequest.chunkData);
-            pendingRequest.chunkData.clear();
-            pendingRequest.state = ReqStates::BodyChunkSize;
-          }
-          break;
-        }
-        default:
-          break;
+    case ReqStates::BodyChunkData: {
+      const size_t size = std::min<size_t>(packet.size(), pendingRequest.chunkSize);
+      pendingRequest.addToBody(packet, size);
+      packet.ignore(size);
+      pendingRequest.chunkSize -= size;
+      if (pendingRequest.chunkSize > 0)
+        return ParseResults::Incomplete;
+      pendingRequest.setState(ReqStates::BodyChunkEnd);
+      return ParseResults::Done;
+    }
+    case ReqStates::BodyChunkEnd: {
+      if (packet.size() < 2)
+        return ParseResults::Incomplete;
+      if (packet[0] != '\r' || packet[1] != '\n') {
+        this->sendBadRequest(sock, ErrorCodes::BadRequest, "Chunk data not terminated by CRLF");
+        return ParseResults::Error;
       }
+      packet.ignore(2);
+      pendingRequest.setState(ReqStates::BodyChunkSize);
+      return ParseResults::Done;
     }
-  }
-  if (pendingRequest.lastCheck()) {
-    // handle multiform-data
-    // pendingRequest.handleMultiformData();
-    const Request req(pendingRequest);
-    Response res(req, NULL);
-    Logger::info
-      << "New request from " << Logger::param(sock) << ": " << std::newl
-      << Logger::param(req);
-    this->setClientToWrite(sock);
-    this->onRequest(req, res);
-    this->pendingRequests.erase(sock);
+    case ReqStates::BodyTrailers: {
+      // trailer fields are skipped, up to the empty line
+      const uint64_t eol = RequestParser::FindLine(packet, 0);
+      if (eol == RequestParser::npos)
+        return ParseResults::Incomplete;
+      packet.ignore(eol + 1);
+      if (eol <= 1)
+        pendingRequest.setState(ReqStates::Done);
+      return ParseResults::Done;
+    }
+    default:
+      return ParseResults::Done;
   }
 }
 
@@ -219,11 +272,11 @@ void WebSocket::sendBadRequest(Socket::Connection& sock, int statusCode, const s
     << "Sending " << Logger::param(statusCode) << " to " << Logger::param(sock) << ": " << logMsg
     << std::newl;
   PendingRequest& pendingRequest = this->pendingRequests.at(sock);
-  pendingRequest.setBody("");
+  pendingRequest.getBody().clear();
   pendingRequest.setProtocol("HTTP/1.1");
-  Request req(pendingRequest);
-  Response resp(req, NULL);
+  Response resp(pendingRequest, NULL);
   resp.getHeaders().set("Connection", "close");
+  resp.getHeaders().remove(Headers::Names::KeepAlive);
   this->setClientToWrite(sock);
   resp.status(statusCode).send();
   this->pendingRequests.erase(sock);
@@ -235,16 +288,12 @@ void WebSocket::trackCGIResponse(pid_t pid, int std[2], Response& res) {
   if (!this->trackProcess(pid, res.getRequest().getClient(), std))
     return;
   Socket::Process& process = this->getProcess(pid);
-  process.getWriteBuffer() = res.getRequest().getRawBody();
-  const_cast<ByteStream&>(res.getRequest().getRawBody()).clear();
-  this->pendingCGIResponses.insert(
-    std::make_pair(
-      pid,
-      (PendingResponse) {
-    res.getRequest(), res
-  }));
-  PendingResponse& pending = this->pendingCGIResponses.at(pid);
-  pending.response = Response(pending.request, res.getRoute());
+  // spilled bodies are read by the process straight from their file
+  const RequestBody& body = res.getRequest().getBody();
+  if (!body.isFile())
+    process.getWriteBuffer() = body.getData();
+  const_cast<RequestBody&>(body).clear();
+  this->pendingCGIResponses.insert(std::make_pair(pid, new PendingResponse(res.getRequest(), res.getRoute())));
   const Socket::File& client = res.getRequest().getClient().getHandle();
   this->pendingCGIProcesses.insert(std::make_pair(client, pid));
   Logger::debug
@@ -256,20 +305,97 @@ void WebSocket::trackCGIResponse(pid_t pid, int std[2], Response& res) {
 void WebSocket::onProcessRead(Socket::Process& process) {
   if (this->pendingCGIResponses.count(process.getId()) == 0)
     return;
-  PendingResponse& pending = this->pendingCGIResponses.at(process.getId());
+  PendingResponse& pending = *this->pendingCGIResponses.at(process.getId());
   Response& res = pending.response;
   const_cast<ByteStream&>(res.getRawBody()).put(process.getReadBuffer());
   process.getReadBuffer().clear();
 }
 
 void WebSocket::onProcessExit(const Socket::Process& process, Socket::Process::ExitCodes::Code code) {
-  PendingResponse& pending = this->pendingCGIResponses.at(process.getId());
-  Response& res = pending.response;
+  PendingResponse* pending = this->pendingCGIResponses.at(process.getId());
+  Socket::Connection& client = const_cast<Socket::Connection&>(process.getClient());
   Logger::debug
-    << "Creating CGI response for client: " << Logger::param(process.getClient())
+    << "Creating CGI response for client: " << Logger::param(client)
     << " because of " << Socket::Process::ExitCodes::ToString(code) << std::newl;
-  this->pendingCGIProcesses.erase(process.getClient());
-  this->setClientToWrite(const_cast<Socket::Connection&>(process.getClient()));
+  this->pendingCGIProcesses.erase(client);
+  this->setClientToWrite(client);
+  this->sendCGIResponse(pending->response, code);
+  this->pendingCGIResponses.erase(process.getId());
+  delete pending;
+  // requests pipelined behind the cgi one were left in the read buffer
+  if (code != Socket::Process::ExitCodes::ClientTimeout && !client.getReadBuffer().empty())
+    this->handleClientPacket(client);
+}
+
+FastCGI::Pool& WebSocket::getFastCGIPool(const std::string& path, const std::vector<std::string>& args, int minWorkers, int maxWorkers) {
+  std::string key = path;
+  for (size_t i = 0; i < args.size(); i++)
+    key.append(1, '\0').append(args[i]);
+  std::map<std::string, FastCGI::Pool*>::iterator it = this->fastCGIPools.find(key);
+  // interpreters sharing a command share its workers, the first one sizes the pool
+  if (it != this->fastCGIPools.end())
+    return *it->second;
+  FastCGI::Pool* pool = new FastCGI::Pool(*this, path, args, minWorkers, maxWorkers);
+  this->fastCGIPools.insert(std::make_pair(key, pool));
+  return *pool;
+}
+
+void WebSocket::startFastCGIPools() {
+  for (std::map<std::string, FastCGI::Pool*>::iterator it = this->fastCGIPools.begin(); it != this->fastCGIPools.end(); ++it)
+    it->second->start();
+}
+
+bool WebSocket::trackFastCGIResponse(FastCGI::Pool& pool, ByteStream& params, int bodyFd, Response& res) {
+  const Socket::File& client = res.getRequest().getClient().getHandle();
+  if (this->pendingFastCGIJobs.count(client) > 0) {
+    if (bodyFd >= 0)
+      close(bodyFd);
+    return false;
+  }
+  FastCGI::Job* job = new FastCGI::Job(pool, res, params, bodyFd);
+  // submit may finish the job right away
+  this->pendingFastCGIJobs.insert(std::make_pair(static_cast<int>(client), job));
+  this->submittingClient = client;
+  const bool submitted = pool.submit(job);
+  this->submittingClient = -1;
+  if (!submitted) {
+    this->pendingFastCGIJobs.erase(client);
+    delete job;
+    return false;
+  }
+  Logger::debug
+    << "Tracking fastcgi response to client " << Logger::param(client)
+    << " in the pool of " << Logger::param(pool.getPath()) << std::newl;
+  return true;
+}
+
+void WebSocket::onFastCGIExit(FastCGI::Job& job, Socket::Process::ExitCodes::Code code) {
+  Socket::Connection& client = job.getClient();
+  Logger::debug
+    << "Creating FastCGI response for client: " << Logger::param(client)
+    << " because of " << Socket::Process::ExitCodes::ToString(code) << std::newl;
+  this->pendingFastCGIJobs.erase(client);
+  this->setClientToWrite(client);
+  this->sendCGIResponse(job.getPending().response, code);
+  // requests pipelined behind the fastcgi one were left in the read buffer,
+  // a job finished while being submitted leaves them to the handleClientPacket loop that's still running
+  if (
+    code != Socket::Process::ExitCodes::ClientTimeout &&
+    static_cast<int>(client) != this->submittingClient &&
+    !client.getReadBuffer().empty()
+    )
+    this->handleClientPacket(client);
+}
+
+void WebSocket::onUpstreamEvent(const Socket::File& file) {
+  file.getOwner<FastCGI::Worker>().onEvent(file);
+}
+
+void WebSocket::onUpstreamTimeout(Socket::Timer& timer) {
+  timer.getOwner<FastCGI::Worker>().onTimeout();
+}
+
+void WebSocket::sendCGIResponse(Response& res, Socket::Process::ExitCodes::Code code) {
   switch (code) {
   case Socket::Process::ExitCodes::Normal: {
     const HTTP::Routing::Module* mod = res.getRoute()->getModule(Routing::Types::CGI);
@@ -305,5 +431,4 @@ void WebSocket::onProcessExit(const Socket::Process& process, Socket::Process::E
     break;
   }
   res.send("");
-  this->pendingCGIResponses.erase(process.getId());
-}
\ No newline at end of file
+}
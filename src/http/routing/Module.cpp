@@ -6,10 +6,10 @@
 using namespace HTTP::Routing;
 
 Module::Module(const Types::Type type, const Route& route, const YAML::Node& node)
-  : type(type), route(route), node(node) {}
+  : type(type), route(route), node(node), methods(~0u), noMatch(Middleware::Next) {}
 
 Module::Module(const Module& other)
-  : type(other.type), route(other.route), node(other.node) {}
+  : type(other.type), route(other.route), node(other.node), methods(other.methods), noMatch(other.noMatch) {}
 
 Module::~Module() {}
 
@@ -22,32 +22,29 @@ void Module::init() {
     throw std::runtime_error("Settings must be a map");
   if (settings.has("methods") && !settings["methods"].is<YAML::Types::Sequence>())
     throw std::runtime_error("Methods must be a sequence");
-}
-
-Middleware Module::getNoMatch() const {
-  if (!this->node.has("no_match")) return Middleware(Middleware::Next);
-  if (this->node["no_match"].is<int>())
-    return Middleware(this->node["no_match"].as<int>());
-  Middleware::Type type = Middleware::FromString(this->node["no_match"].as<std::string>());
-  return Middleware(type);
+  this->methods = ~0u;
+  if (settings.has("methods")) {
+    const YAML::Node& methods = settings["methods"];
+    this->methods = 0;
+    for (uint64_t i = 0; i < methods.size(); ++i) {
+      const Methods::Method method = Methods::FromString(methods[i].getValue());
+      if (method != Methods::UNK)
+        this->methods |= Methods::ToBit(method);
+    }
+  }
+  this->noMatch = Middleware(Middleware::Next);
+  if (this->node.has("no_match")) {
+    if (this->node["no_match"].is<int>())
+      this->noMatch = Middleware(this->node["no_match"].as<int>());
+    else
+      this->noMatch = Middleware(Middleware::FromString(this->node["no_match"].as<std::string>()));
+  }
 }
 
 const HTTP::ServerConfiguration* Module::getServer() const {
   return this->route.server;
 }
 
-bool Module::isMethodAllowed(Methods::Method method) const {
-  const YAML::Node& settings = this->getSettings();
-  if (!settings.has("methods") || !settings["methods"].is<YAML::Types::Sequence>())
-    return true;
-  const YAML::Node& methods = settings["methods"];
-  for (uint64_t i = 0; i < methods.size(); ++i) {
-    if (Methods::FromString(methods[i].getValue()) == method)
-      return true;
-  }
-  return false;
-}
-
 bool Module::next(Response& res, int statusCode /* = -1 */) const {
   const Middleware noMatch = this->getNoMatch();
   if (statusCode == -1) {
@@ -84,13 +84,6 @@ CGI::CGI(const CGI& other) : Module(other) {
   this->init();
 }
 
-const std::string& CGI::getBasePathInfo() const {
-  const YAML::Node& settings = this->getSettings();
-  if (!settings.has("path_info"))
-    return this->getRoot();
-  return settings["path_info"].getValue();
-}
-
 std::string CGI::getResolvedPath(const Request& req) const {
   const std::string& root = this->getRoot();
   std::string path = req.getPath();
@@ -163,17 +156,21 @@ void CGI::init() {
   if (*root.rbegin() != '/')
     root.append("/");
   root = Utils::expandPath(root);
+  this->root = root;
+  this->basePathInfo = settings.has("path_info") ? settings["path_info"].getValue() : root;
   if (
     !settings.has("interpreters") ||
     !settings["interpreters"].is<YAML::Types::Sequence>() ||
     settings["interpreters"].size() == 0)
     throw std::runtime_error("CGI route must have at least 1 interpreter");
+  // interpreterExtMap points into it, it must not reallocate
+  this->interpreters.reserve(settings["interpreters"].size());
   for (size_t i = 0; i < settings["interpreters"].size(); i++) {
     this->interpreters.push_back(Interpreter(settings["interpreters"][i]));
     const Interpreter& interpreter = this->interpreters.back();
-    const YAML::Node& exts = interpreter.getExtensions();
+    const std::vector<std::string>& exts = interpreter.getExtensions();
     for (size_t j = 0; j < exts.size(); j++) {
-      const std::string& ext = exts[j].getValue();
+      const std::string& ext = exts[j];
       if (this->isExtMapped(ext))
         throw std::runtime_error("CGI route cannot have multiple interpreters for extension: " + ext);
       this->interpreterExtMap[ext] = &interpreter;
@@ -199,49 +196,58 @@ void CGI::generateEnvironment(
 ) const {
   static const ServerManager* serverManager = Instance::Get<ServerManager>();
   const char* const* defaultEnv = serverManager->getEnv();
-  env.reserve(serverManager->getEnvSize() + 32 + req.getHeaders().getAll().size());
+  std::vector<EnvVar> params;
+  this->generateParams(params, req);
+  env.reserve(serverManager->getEnvSize() + params.size());
 
   for (size_t i = 0; defaultEnv[i]; i++)
     env.push_back(defaultEnv[i]);
-  Headers headers = req.getHeaders();
+  for (size_t i = 0; i < params.size(); i++)
+    env.push_back(params[i]);
+}
+
+void CGI::generateParams(
+  std::vector<EnvVar>& params,
+  const Request& req
+) const {
+  static const ServerManager* serverManager = Instance::Get<ServerManager>();
+  params.reserve(32 + req.getHeaders().size());
+  const Headers& headers = req.getHeaders();
   const Socket::Server& server = serverManager->getServer(req.getClient().getServerSock());
-  const std::map<std::string, std::string>& headersMap = headers.getAll();
 
-  if (headers.has("Content-Type"))
-    env.push_back(EnvVar("CONTENT_TYPE", headers.get<std::string>("Content-Type")));
-  if (req.getRawBody().size() > 0)
-    env.push_back(EnvVar("CONTENT_LENGTH", req.getRawBody().size()));
-  headers.remove("Content-Type");
-  headers.remove("Content-Length");
-  env.push_back(EnvVar("GATEWAY_INTERFACE", "CGI/1.1"));
+  const Headers::Entry* contentType = headers.find(Headers::Names::ContentType);
+  if (contentType)
+    params.push_back(EnvVar("CONTENT_TYPE", std::string(contentType->value, contentType->valueSize)));
+  if (req.getBody().size() > 0)
+    params.push_back(EnvVar("CONTENT_LENGTH", req.getBody().size()));
+  params.push_back(EnvVar("GATEWAY_INTERFACE", "CGI/1.1"));
 
   const std::vector<std::string> paths = this->resolvePathInfo(req);
   const std::string requestUri = paths[0];
   const std::string pathInfo = paths[1];
   const std::string pathTranslated = this->resolvePathTranslated(req, pathInfo);
 
-  env.push_back(EnvVar("REQUEST_URI", requestUri));
-  env.push_back(EnvVar("PATH_INFO", requestUri));
-  env.push_back(EnvVar("PATH_TRANSLATED", pathTranslated));
-  env.push_back(EnvVar("QUERY_STRING", req.getQuery()));
-  env.push_back(EnvVar("REMOTE_ADDR", req.getClient().getAddress()));
-  env.push_back(EnvVar("REMOTE_PORT", Utils::toString(req.getClient().getPort())));
-  env.push_back(EnvVar("REQUEST_METHOD", Methods::ToString(req.getMethod())));
-  env.push_back(EnvVar("SCRIPT_NAME", requestUri));
-  env.push_back(EnvVar("SERVER_NAME", server.address));
-  env.push_back(EnvVar("SERVER_PORT", Utils::toString(server.port)));
-  env.push_back(EnvVar("SERVER_PROTOCOL", req.getProtocol()));
-  env.push_back(EnvVar("SERVER_SOFTWARE", settings->get<std::string>("misc.name")));
-  for (
-    std::map<std::string, std::string>::const_iterator it = headersMap.begin();
-    it != headersMap.end();
-    it++
-    ) {
-    std::string key = it->first;
-    const std::string& value = it->second;
+  params.push_back(EnvVar("REQUEST_URI", requestUri));
+  params.push_back(EnvVar("PATH_INFO", requestUri));
+  params.push_back(EnvVar("PATH_TRANSLATED", pathTranslated));
+  params.push_back(EnvVar("QUERY_STRING", req.getQuery()));
+  params.push_back(EnvVar("REMOTE_ADDR", req.getClient().getAddress()));
+  params.push_back(EnvVar("REMOTE_PORT", Utils::toString(req.getClient().getPort())));
+  params.push_back(EnvVar("REQUEST_METHOD", Methods::ToString(req.getMethod())));
+  params.push_back(EnvVar("SCRIPT_NAME", requestUri));
+  params.push_back(EnvVar("SERVER_NAME", server.address));
+  params.push_back(EnvVar("SERVER_PORT", Utils::toString(server.port)));
+  params.push_back(EnvVar("SERVER_PROTOCOL", req.getProtocol()));
+  params.push_back(EnvVar("SERVER_SOFTWARE", settings->getSnapshot().name));
+  for (size_t i = 0; i < headers.size(); ++i) {
+    const Headers::Entry& entry = headers[i];
+    // already passed as CONTENT_TYPE & CONTENT_LENGTH
+    if (entry.id == Headers::Names::ContentType || entry.id == Headers::Names::ContentLength)
+      continue;
+    std::string key = entry.name;
     Utils::toUppercase(key);
     std::replace(key.begin(), key.end(), '-', '_');
-    env.push_back(EnvVar("HTTP_" + key, value));
+    params.push_back(EnvVar("HTTP_" + key, std::string(entry.value, entry.valueSize)));
   }
 }
 
@@ -251,11 +257,11 @@ std::vector<std::string> CGI::generateArgs(
   const Request& req
 ) const {
   (void)req;
-  const YAML::Node& baseArgs = intr->getArgs();
+  const std::vector<std::string>& baseArgs = intr->getArgs();
   std::vector<std::string> args(baseArgs.size() + 1);
   args[0] = intr->getPath();
   for (uint64_t i = 0; i < baseArgs.size(); i++) {
-    std::string arg = baseArgs[i].getValue();
+    std::string arg = baseArgs[i];
     uint64_t pos;
     while ((pos = arg.find("$file")) != std::string::npos)
       arg.replace(pos, 5, Utils::basename(filePath));
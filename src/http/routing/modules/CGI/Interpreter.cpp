@@ -3,10 +3,14 @@
 #include <utils/misc.hpp>
 #include <utils/Logger.hpp>
 #include <http/ServerManager.hpp>
+#include <http/FastCGI.hpp>
+#include <Settings.hpp>
+#include <fcntl.h>
 
 using namespace HTTP::Routing;
 
 static HTTP::ServerManager* serverManager = Instance::Get<HTTP::ServerManager>();
+static const Settings* settings = Instance::Get<Settings>();
 
 CGI::Interpreter::Interpreter(const YAML::Node& node) : node(node) {
   this->init();
@@ -14,18 +18,19 @@ CGI::Interpreter::Interpreter(const YAML::Node& node) : node(node) {
 
 CGI::Interpreter::~Interpreter() {}
 
-CGI::Interpreter::Interpreter(const Interpreter& other) : node(other.node) {
-  this->init();
-}
+CGI::Interpreter::Interpreter(const Interpreter& other)
+  : node(other.node),
+  name(other.name),
+  path(other.path),
+  extensions(other.extensions),
+  args(other.args),
+  mode(other.mode),
+  minWorkers(other.minWorkers),
+  maxWorkers(other.maxWorkers),
+  pool(other.pool) {}
 
 bool CGI::Interpreter::hasExtension(const std::string& extVal) const {
-  const YAML::Node& exts = this->getExtensions();
-  for (size_t i = 0; i < exts.size(); i++) {
-    const YAML::Node& ext = exts[i];
-    if (ext.getValue() == extVal)
-      return true;
-  }
-  return false;
+  return std::find(this->extensions.begin(), this->extensions.end(), extVal) != this->extensions.end();
 }
 
 void CGI::Interpreter::init() {
@@ -38,12 +43,45 @@ void CGI::Interpreter::init() {
     !this->node["extensions"].is<YAML::Types::Sequence>() ||
     this->node["extensions"].size() == 0)
     throw std::runtime_error("CGI interpreter must have at least 1 extension");
-  if (
+  this->mode = Modes::CGI;
+  if (this->node.has("mode")) {
+    const std::string& mode = this->node["mode"].getValue();
+    if (mode == "fastcgi")
+      this->mode = Modes::FastCGI;
+    else if (mode != "cgi")
+      throw std::runtime_error("CGI interpreter mode must be cgi or fastcgi, got: " + mode);
+  }
+  // fastcgi workers find the script in SCRIPT_FILENAME, they may not need any
+  if (this->mode == Modes::CGI && (
     !this->node.has("args") ||
     !this->node["args"].is<YAML::Types::Sequence>() ||
-    this->node["args"].size() == 0)
+    this->node["args"].size() == 0))
     throw std::runtime_error("CGI interpreter must have at least 1 arg (preferably with $file expander)");
-
+  if (this->node.has("args") && !this->node["args"].is<YAML::Types::Sequence>())
+    throw std::runtime_error("CGI interpreter args must be a sequence");
+  this->name = this->node["name"].getValue();
+  this->path = this->node["path"].getValue();
+  const YAML::Node& extensions = this->node["extensions"];
+  for (size_t i = 0; i < extensions.size(); i++)
+    this->extensions.push_back(extensions[i].getValue());
+  if (this->node.has("args")) {
+    const YAML::Node& args = this->node["args"];
+    for (size_t i = 0; i < args.size(); i++)
+      this->args.push_back(args[i].getValue());
+  }
+  const Settings::Snapshot& snapshot = settings->getSnapshot();
+  this->minWorkers = snapshot.fastCGIMinWorkers;
+  this->maxWorkers = snapshot.fastCGIMaxWorkers;
+  this->pool = NULL;
+  if (this->mode != Modes::FastCGI)
+    return;
+  if (this->node.has("min_workers"))
+    this->minWorkers = this->node["min_workers"].as<int>();
+  if (this->node.has("max_workers"))
+    this->maxWorkers = this->node["max_workers"].as<int>();
+  if (this->minWorkers < 0 || this->maxWorkers < 1 || this->minWorkers > this->maxWorkers)
+    throw std::runtime_error("CGI interpreter " + this->name + " must have 0 <= min_workers <= max_workers & max_workers >= 1");
+  this->pool = &serverManager->getFastCGIPool(this->path, this->args, this->minWorkers, this->maxWorkers);
 }
 
 bool CGI::Interpreter::run(const std::string& filePath, const Request& req, Response& res, const CGI* cgi) const {
@@ -56,14 +94,26 @@ bool CGI::Interpreter::run(const std::string& filePath, const Request& req, Resp
       << Logger::param(execPath) << ". Skipping CGI module.." << std::newl;
     return cgi->next(res);
   }
+  if (this->mode == Modes::FastCGI)
+    return this->runFastCGI(filePath, req, res, cgi);
   Logger::debug
     << "Preparing cgi execution for script: "
     << Logger::param(filePath)
     << " & interpreter: " << Logger::param(this->getName()) << std::newl;
-  int stdinput[2];
+  int stdinput[2] = { -1, -1 };
   int stdoutput[2];
 
-  if (pipe(stdinput) < -1) {
+  // spilled bodies are given as stdin directly, instead of going through a pipe
+  if (req.getBody().isFile()) {
+    stdinput[0] = open(req.getBody().getPath().c_str(), O_RDONLY);
+    if (stdinput[0] < 0) {
+      Logger::error
+        << "Failed to open the request body for cgi req "
+        << Logger::param(req) << std::newl;
+      return cgi->next(res, 500);
+    }
+  }
+  else if (pipe(stdinput) < -1) {
     Logger::error
       << "Failed to open a pipe for cgi req "
       << Logger::param(req) << std::newl;
@@ -119,7 +169,8 @@ bool CGI::Interpreter::run(const std::string& filePath, const Request& req, Resp
     dups[0] = dup2(stdinput[0], STDIN_FILENO);
     dups[1] = dup2(stdoutput[1], STDOUT_FILENO);
     close(stdinput[0]);
-    close(stdinput[1]);
+    if (stdinput[1] >= 0)
+      close(stdinput[1]);
     close(stdoutput[0]);
     close(stdoutput[1]);
     execve(execPath.c_str(), args.data(), envp.data());
@@ -129,4 +180,36 @@ bool CGI::Interpreter::run(const std::string& filePath, const Request& req, Resp
     std::exit(1);
   }
   return true;
-}
\ No newline at end of file
+}
+
+bool CGI::Interpreter::runFastCGI(const std::string& filePath, const Request& req, Response& res, const CGI* cgi) const {
+  int bodyFd = -1;
+  // spilled bodies are streamed to the worker from their file
+  if (req.getBody().isFile()) {
+    bodyFd = open(req.getBody().getPath().c_str(), O_RDONLY | O_CLOEXEC);
+    if (bodyFd < 0) {
+      Logger::error
+        << "Failed to open the request body for fastcgi req "
+        << Logger::param(req) << std::newl;
+      return cgi->next(res, 500);
+    }
+  }
+  std::vector<EnvVar> params;
+  cgi->generateParams(params, req);
+  params.push_back(EnvVar("SCRIPT_FILENAME",
+    filePath[0] == '/' ? filePath : Utils::resolvePath(2, Utils::getCurrentWorkingDirectory().c_str(), filePath.c_str())
+  ));
+  ByteStream encoded;
+  for (size_t i = 0; i < params.size(); i++)
+    FastCGI::PutParam(encoded, params[i].name, params[i].value);
+  Logger::debug
+    << "Handing script " << Logger::param(filePath)
+    << " to the fastcgi pool of interpreter " << Logger::param(this->getName()) << std::newl;
+  if (!serverManager->trackFastCGIResponse(*this->pool, encoded, bodyFd, res)) {
+    Logger::error
+      << "No fastcgi worker available for req "
+      << Logger::param(req) << std::newl;
+    return cgi->next(res, 500);
+  }
+  return true;
+}
@@ -5,22 +5,33 @@ using namespace HTTP;
 using namespace HTTP::Routing;
 
 Redirect::Redirect(const Route& route, const YAML::Node& node)
-  : Module(Types::Redirect, route, node) {
+  : Module(Types::Redirect, route, node), partial(false), permanent(true) {
   this->init();
 }
 
 Redirect::~Redirect() {}
 
-Redirect::Redirect(const Redirect& other) : Module(other) {
+Redirect::Redirect(const Redirect& other)
+  : Module(other), partial(false), permanent(true) {
   this->init();
 }
 
-
-bool Redirect::isRedirectPartial() const {
+void Redirect::init() {
+  this->Module::init();
   const YAML::Node& settings = this->getSettings();
-  if (!settings.has("partial"))
-    return this->getServer()->getDefaultRoute()->isRedirectPartial();
-  return settings["partial"].as<bool>();
+  if (!settings.has("uri") || !settings["uri"].is<YAML::Types::Scalar>())
+    throw std::runtime_error("Redirect route must have an uri");
+  this->uri = settings["uri"].getValue();
+  // the default route only exists once it is done initializing
+  const Routes::Default* defaultRoute = this->getServer()->getDefaultRoute();
+  if (settings.has("partial"))
+    this->partial = settings["partial"].as<bool>();
+  else
+    this->partial = defaultRoute ? defaultRoute->isRedirectPartial() : false;
+  if (settings.has("type"))
+    this->permanent = settings["type"].getValue() == "permanent";
+  else
+    this->permanent = defaultRoute ? defaultRoute->isRedirectPermanent() : false;
 }
 
 std::string Redirect::buildRedirectPath(const Request& req) const {
@@ -37,13 +48,6 @@ std::string Redirect::buildRedirectPath(const Request& req) const {
   return uriHost;
 }
 
-bool Redirect::isRedirectPermanent() const {
-  const YAML::Node& settings = this->getSettings();
-  if (!settings.has("type"))
-    return this->getServer()->getDefaultRoute()->isRedirectPermanent();
-  return settings["type"].getValue() == "permanent";
-}
-
 
 bool Redirect::handle(const Request& req, Response& res) const {
   res.redirect(this->buildRedirectPath(req), this->isRedirectPermanent());
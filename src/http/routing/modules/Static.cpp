@@ -6,48 +6,20 @@
 using namespace HTTP;
 using namespace HTTP::Routing;
 
-Static::Static(const Route& route, const YAML::Node& node)
-  : Module(Types::Static, route, node) {
-  this->init();
-}
+static Settings* settings = Instance::Get<Settings>();
 
-Static::~Static() {}
-
-Static::Static(const Static& other) : Module(other) {
+Static::Static(const Route& route, const YAML::Node& node)
+  : Module(Types::Static, route, node), cache(NULL), directoryListing(false), ignoreHidden(true) {
   this->init();
 }
 
-const std::string& Static::getRoot() const {
-  const YAML::Node& settings = this->getSettings();
-  return settings["root"].getValue();
+Static::~Static() {
+  delete this->cache;
 }
 
-const std::string Static::getIndex() const {
-  const YAML::Node& settings = this->getSettings();
-  if (!settings.has("index"))
-    return this->getServer()->getDefaultRoute()->getIndex();
-  return settings["index"].getValue();
-}
-
-const std::string& Static::getRedirection() const {
-  const YAML::Node& settings = this->getSettings();
-  if (!settings.has("send_to"))
-    return this->getRoot();
-  return settings["send_to"].getValue();
-}
-
-bool Static::isDirectoryListingAllowed() const {
-  const YAML::Node& settings = this->getSettings();
-  if (!settings.has("directory_listing"))
-    return this->getServer()->getDefaultRoute()->hasDirectoryListing();
-  return settings["directory_listing"].as<bool>();
-}
-
-bool Static::ignoreHiddenFiles() const {
-  const YAML::Node& settings = this->getSettings();
-  if (!settings.has("ignore_hidden"))
-    return this->getServer()->getDefaultRoute()->ignoreHiddenFiles();
-  return settings["ignore_hidden"].as<bool>();
+Static::Static(const Static& other)
+  : Module(other), cache(NULL), directoryListing(false), ignoreHidden(true) {
+  this->init();
 }
 
 void Static::init() {
@@ -59,6 +31,44 @@ void Static::init() {
   if (*root.rbegin() != '/')
     root.append("/");
   root = Utils::expandPath(root);
+  this->root = root;
+  this->redirection = settings.has("send_to") ? settings["send_to"].getValue() : root;
+  // the default route only exists once it is done initializing
+  const Routes::Default* defaultRoute = this->getServer()->getDefaultRoute();
+  if (settings.has("index"))
+    this->index = settings["index"].getValue();
+  else
+    this->index = defaultRoute ? defaultRoute->getIndex() : ::settings->getSnapshot().defaultIndex;
+  if (settings.has("directory_listing"))
+    this->directoryListing = settings["directory_listing"].as<bool>();
+  else
+    this->directoryListing = defaultRoute ? defaultRoute->hasDirectoryListing() : false;
+  if (settings.has("ignore_hidden"))
+    this->ignoreHidden = settings["ignore_hidden"].as<bool>();
+  else
+    this->ignoreHidden = defaultRoute ? defaultRoute->ignoreHiddenFiles() : true;
+  if (!settings.has("cache"))
+    return;
+  const YAML::Node& cache = settings["cache"];
+  if (cache.is<bool>() && !cache.as<bool>())
+    return;
+  uint64_t maxFileSize = ::settings->getSnapshot().responseCacheMaxFileSize;
+  uint64_t maxMemory = ::settings->getSnapshot().responseCacheMaxMemory;
+  if (cache.is<YAML::Types::Map>()) {
+    if (cache.has("max_file_size")) {
+      if (!cache["max_file_size"].is<int>() || cache["max_file_size"].as<int>() < 0)
+        throw std::runtime_error("Static cache max_file_size must be a non-negative integer");
+      maxFileSize = cache["max_file_size"].as<uint64_t>();
+    }
+    if (cache.has("max_memory")) {
+      if (!cache["max_memory"].is<int>() || cache["max_memory"].as<int>() < 0)
+        throw std::runtime_error("Static cache max_memory must be a non-negative integer");
+      maxMemory = cache["max_memory"].as<uint64_t>();
+    }
+  }
+  else if (!cache.is<bool>())
+    throw std::runtime_error("Static cache must be a boolean or a map");
+  this->cache = new ResponseCache(maxFileSize, maxMemory);
 }
 
 std::string Static::getResolvedPath(const Request& req) const {
@@ -76,11 +86,12 @@ std::string Static::buildDirectoryListing(const std::string& path) const {
 
 bool Static::handle(const Request& req, Response& res) const {
   const std::string path = this->getResolvedPath(req);
-  Logger::debug
-    << "generated path " << Logger::param(path)
-    << " based on root " << Logger::param(this->getRoot())
-    << " and req path " << Logger::param(req.getPath())
-    << std::newl;
+  if (Logger::debug.isEnabled())
+    Logger::debug
+      << "generated path " << Logger::param(path)
+      << " based on root " << Logger::param(this->getRoot())
+      << " and req path " << Logger::param(req.getPath())
+      << std::newl;
   switch (req.getMethod()) {
   case Methods::GET:
   case Methods::HEAD:
@@ -98,15 +109,21 @@ bool Static::handle(const Request& req, Response& res) const {
 }
 
 bool Static::handleGet(const std::string& path, const Request& req, Response& res) const {
+  if (Utils::basename(path).find_first_of('.') == 0 && this->ignoreHiddenFiles())
+    return this->next(res);
+  FileCache* cache = Instance::Get<FileCache>();
+  // regular files come straight from the cache
+  const FileCache::Entry* file = cache->get(path);
+  if (file)
+    return this->handleFile(*file, req, res);
   struct stat st;
   if (stat(path.c_str(), &st) == -1)
     return this->next(res);
-  if (Utils::basename(path).find_first_of('.') == 0 && this->ignoreHiddenFiles())
-    return this->next(res);
   if (S_ISDIR(st.st_mode)) {
     std::string indexPath = Utils::resolvePath(2, path.c_str(), this->getIndex().c_str());
-    if (access(indexPath.c_str(), F_OK) == 0)
-      return this->handleFile(indexPath, req, res);
+    const FileCache::Entry* index = cache->get(indexPath);
+    if (index)
+      return this->handleFile(*index, req, res);
     if (!this->isDirectoryListingAllowed())
       return this->next(res);
     if (*req.getPath().rbegin() != '/')
@@ -116,10 +133,7 @@ bool Static::handleGet(const std::string& path, const Request& req, Response& re
       << "Directory listing size: " << Logger::param(listing.size()) << std::newl;
     return (res.status(200).send(listing), true);
   }
-  else if (S_ISREG(st.st_mode))
-    return this->handleFile(path, req, res);
-  else
-    return this->next(res, 403);
+  return this->next(res, 403);
 }
 
 bool Static::handleDelete(const std::string& path, const Request& req, Response& res) const {
@@ -128,6 +142,9 @@ bool Static::handleDelete(const std::string& path, const Request& req, Response&
     return this->next(res);
   if (S_ISDIR(st.st_mode))
     return this->next(res, 403);
+  Instance::Get<FileCache>()->invalidate(path);
+  if (this->cache)
+    this->cache->invalidate(path);
   if (std::remove(path.c_str()) != 0) {
     Logger::warning
       << "Got request " << Logger::param(req)
@@ -146,15 +163,20 @@ bool Static::handleUploads(const std::string& path, const Request& req, Response
     return this->next(res, req.isExpecting() ? 417 : 204);
   if (req.isExpecting())
     return this->next(res, 100);
-  std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
-  if (!file.is_open() || !file.good())
-    return this->next(res, 500);
   Logger::debug
     << "Uploading file " << Logger::param(path)
-    << " with size " << Logger::param(req.getRawBody().size())
+    << " with size " << Logger::param(req.getBody().size())
     << std::newl;
-  file.write(reinterpret_cast<const char*>(req.getRawBody().data()), req.getRawBody().size());
-  file.close();
+  // spilled bodies are only renamed into place
+  if (!const_cast<RequestBody&>(req.getBody()).saveTo(path)) {
+    Logger::error
+      << "Could not upload file " << Logger::param(path)
+      << ": " << Logger::param(strerror(errno)) << std::newl;
+    return this->next(res, 500);
+  }
+  Instance::Get<FileCache>()->invalidate(path);
+  if (this->cache)
+    this->cache->invalidate(path);
   if (this->getRedirection() != this->getRoot()) {
     std::string filePath(path);
     filePath.erase(0, this->getRoot().size());
@@ -165,25 +187,26 @@ bool Static::handleUploads(const std::string& path, const Request& req, Response
   return true;
 }
 
-bool Static::handleFile(const std::string& path, const Request& req, Response& res) const {
-  struct stat st;
-  if (stat(path.c_str(), &st) == -1)
-    return this->next(res);
-  if (!this->clientHasFile(req, path, &st))
-    return (res.status(200).sendFile(path, true, &st), true);
-  res.setupStaticFileHeaders(path, &st);
+bool Static::handleFile(const FileCache::Entry& file, const Request& req, Response& res) const {
+  if (!this->clientHasFile(req, file)) {
+    // cached responses are serialized with HTTP/1.1 as protocol
+    const ResponseCache::Entry* cached = this->cache && req.getProtocol() == "HTTP/1.1"
+      ? this->cache->get(file, res) : NULL;
+    if (cached)
+      return (res.status(200).sendCached(*cached), true);
+    return (res.status(200).sendFile(file), true);
+  }
+  res.setupStaticFileHeaders(file);
   return this->next(res, 304);
 }
 
-bool Static::clientHasFile(const Request& req, const std::string& path, struct stat* st) const {
-  if (!st)
-    return false;
-  std::string etag = Utils::httpETag(path, st->st_mtime, st->st_size);
-  std::string lastModified = Utils::getJSONDate(st->st_mtime);
+bool Static::clientHasFile(const Request& req, const FileCache::Entry& file) const {
   const Headers& headers = req.getHeaders();
-  if (headers.has("If-None-Match") && headers.get<std::string>("If-None-Match") == etag)
+  const Headers::Entry* ifNoneMatch = headers.find(Headers::Names::IfNoneMatch);
+  if (ifNoneMatch && ifNoneMatch->is(file.etag.c_str()))
     return true;
-  if (headers.has("If-Modified-Since") && headers.get<std::string>("If-Modified-Since") == lastModified)
+  const Headers::Entry* ifModifiedSince = headers.find(Headers::Names::IfModifiedSince);
+  if (ifModifiedSince && ifModifiedSince->is(file.lastModified.c_str()))
     return true;
   return false;
-}
\ No newline at end of file
+}
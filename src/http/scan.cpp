@@ -0,0 +1,224 @@
+#include "http/scan.hpp"
+#include "http/utils.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+# define SCAN_X86
+# include <immintrin.h>
+#endif
+
+using namespace HTTP;
+
+// printable bytes (0x21-0x7E) which aren't field tokens, must match specialFieldTokens
+static const char fieldSeparators[] = "\"(),/:<>?@[\\]{}";
+// same for specialUriTokens
+static const char uriSeparator = '"';
+
+struct ClassTable {
+  uint8_t classes[256];
+
+  ClassTable() {
+    std::memset(this->classes, 0, sizeof(this->classes));
+    for (size_t i = 0; i < specialFieldTokens.size(); ++i)
+      this->classes[static_cast<uint8_t>(specialFieldTokens[i])] |= Scan::Classes::FieldToken;
+    for (size_t i = 0; i < specialUriTokens.size(); ++i)
+      this->classes[static_cast<uint8_t>(specialUriTokens[i])] |= Scan::Classes::UriToken;
+  }
+};
+
+static const ClassTable& getClassTable() {
+  static const ClassTable table;
+  return table;
+}
+
+/* Scalar */
+
+static size_t findScalar(const char* data, size_t size, char c) {
+  const void* match = std::memchr(data, c, size);
+  return match ? static_cast<const char*>(match) - data : size;
+}
+
+static size_t findNotInClassScalar(const char* data, size_t size, uint8_t cls) {
+  const uint8_t* classes = getClassTable().classes;
+  for (size_t i = 0; i < size; ++i) {
+    if (!(classes[static_cast<uint8_t>(data[i])] & cls))
+      return i;
+  }
+  return size;
+}
+
+static size_t findNonFieldTokenScalar(const char* data, size_t size) {
+  return findNotInClassScalar(data, size, Scan::Classes::FieldToken);
+}
+
+static size_t findNonUriTokenScalar(const char* data, size_t size) {
+  return findNotInClassScalar(data, size, Scan::Classes::UriToken);
+}
+
+#ifdef SCAN_X86
+
+/* SSE2, 16 bytes at a time */
+
+__attribute__((target("sse2")))
+static inline __m128i printableSSE2(__m128i block) {
+  // signed compares, bytes >= 0x80 are negative so they are left out too
+  return _mm_and_si128(
+    _mm_cmpgt_epi8(block, _mm_set1_epi8(0x20)),
+    _mm_cmpgt_epi8(_mm_set1_epi8(0x7F), block)
+  );
+}
+
+__attribute__((target("sse2")))
+static size_t findSSE2(const char* data, size_t size, char c) {
+  const __m128i needle = _mm_set1_epi8(c);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+    if (mask)
+      return i + __builtin_ctz(mask);
+  }
+  return i + findScalar(data + i, size - i, c);
+}
+
+__attribute__((target("sse2")))
+static size_t findNonFieldTokenSSE2(const char* data, size_t size) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i separators = _mm_setzero_si128();
+    for (size_t s = 0; s < sizeof(fieldSeparators) - 1; ++s)
+      separators = _mm_or_si128(separators, _mm_cmpeq_epi8(block, _mm_set1_epi8(fieldSeparators[s])));
+    const uint32_t mask = _mm_movemask_epi8(_mm_andnot_si128(separators, printableSSE2(block)));
+    if (mask != 0xFFFF)
+      return i + __builtin_ctz(~mask);
+  }
+  return i + findNonFieldTokenScalar(data + i, size - i);
+}
+
+__attribute__((target("sse2")))
+static size_t findNonUriTokenSSE2(const char* data, size_t size) {
+  const __m128i separator = _mm_set1_epi8(uriSeparator);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i valid = _mm_andnot_si128(_mm_cmpeq_epi8(block, separator), printableSSE2(block));
+    const uint32_t mask = _mm_movemask_epi8(valid);
+    if (mask != 0xFFFF)
+      return i + __builtin_ctz(~mask);
+  }
+  return i + findNonUriTokenScalar(data + i, size - i);
+}
+
+/* AVX2, 32 bytes at a time */
+
+__attribute__((target("avx2")))
+static inline __m256i printableAVX2(__m256i block) {
+  return _mm256_and_si256(
+    _mm256_cmpgt_epi8(block, _mm256_set1_epi8(0x20)),
+    _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7F), block)
+  );
+}
+
+__attribute__((target("avx2")))
+static size_t findAVX2(const char* data, size_t size, char c) {
+  const __m256i needle = _mm256_set1_epi8(c);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+    if (mask)
+      return i + __builtin_ctz(mask);
+  }
+  return i + findSSE2(data + i, size - i, c);
+}
+
+__attribute__((target("avx2")))
+static size_t findNonFieldTokenAVX2(const char* data, size_t size) {
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i separators = _mm256_setzero_si256();
+    for (size_t s = 0; s < sizeof(fieldSeparators) - 1; ++s)
+      separators = _mm256_or_si256(separators, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(fieldSeparators[s])));
+    const uint32_t mask = _mm256_movemask_epi8(_mm256_andnot_si256(separators, printableAVX2(block)));
+    if (mask != 0xFFFFFFFFu)
+      return i + __builtin_ctz(~mask);
+  }
+  return i + findNonFieldTokenSSE2(data + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static size_t findNonUriTokenAVX2(const char* data, size_t size) {
+  const __m256i separator = _mm256_set1_epi8(uriSeparator);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i valid = _mm256_andnot_si256(_mm256_cmpeq_epi8(block, separator), printableAVX2(block));
+    const uint32_t mask = _mm256_movemask_epi8(valid);
+    if (mask != 0xFFFFFFFFu)
+      return i + __builtin_ctz(~mask);
+  }
+  return i + findNonUriTokenSSE2(data + i, size - i);
+}
+
+#endif
+
+/* Dispatch */
+
+struct Kernel {
+  Scan::Kernels::Kernel type;
+  size_t (*find)(const char*, size_t, char);
+  size_t (*findNonFieldToken)(const char*, size_t);
+  size_t (*findNonUriToken)(const char*, size_t);
+};
+
+static Kernel selectKernel() {
+  Kernel kernel = { Scan::Kernels::Scalar, findScalar, findNonFieldTokenScalar, findNonUriTokenScalar };
+#ifdef SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    Kernel avx2 = { Scan::Kernels::AVX2, findAVX2, findNonFieldTokenAVX2, findNonUriTokenAVX2 };
+    kernel = avx2;
+  }
+  else if (__builtin_cpu_supports("sse2")) {
+    Kernel sse2 = { Scan::Kernels::SSE2, findSSE2, findNonFieldTokenSSE2, findNonUriTokenSSE2 };
+    kernel = sse2;
+  }
+#endif
+  return kernel;
+}
+
+static const Kernel& getKernel() {
+  static const Kernel kernel = selectKernel();
+  return kernel;
+}
+
+std::string Scan::Kernels::ToString(Kernel kernel) {
+  switch (kernel) {
+    case Scalar: return "Scalar";
+    case SSE2: return "SSE2";
+    case AVX2: return "AVX2";
+    default: return "UNK";
+  }
+}
+
+Scan::Kernels::Kernel Scan::getKernel() {
+  return ::getKernel().type;
+}
+
+bool Scan::is(char c, Classes::Class cls) {
+  return getClassTable().classes[static_cast<uint8_t>(c)] & cls;
+}
+
+size_t Scan::find(const char* data, size_t size, char c) {
+  return ::getKernel().find(data, size, c);
+}
+
+size_t Scan::findNonFieldToken(const char* data, size_t size) {
+  return ::getKernel().findNonFieldToken(data, size);
+}
+
+size_t Scan::findNonUriToken(const char* data, size_t size) {
+  return ::getKernel().findNonUriToken(data, size);
+}
@@ -1,27 +1,39 @@
 #include "http/utils.hpp"
+#include "http/scan.hpp"
 
 bool HTTP::hasFieldToken(char c) {
-  return HTTP::specialFieldTokens.find(c) == std::string::npos;
+  return !Scan::is(c, Scan::Classes::FieldToken);
 }
 
 bool HTTP::hasFieldToken(const std::string& str) {
-  bool insideQuotes = false;
-  for (size_t i = 0; i < str.size(); i++) {
-    char c = str[i];
-    if (c == '"')
-      insideQuotes = !insideQuotes;
-    else if (!insideQuotes && HTTP::hasFieldToken(c))
+  return HTTP::hasFieldToken(str.data(), str.size());
+}
+
+bool HTTP::hasFieldToken(const char* str, size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    i += Scan::findNonFieldToken(str + i, size - i);
+    if (i == size)
+      return false;
+    if (str[i] != '"')
       return true;
+    // anything goes inside quotes, an unterminated one runs until the end
+    i++;
+    i += Scan::find(str + i, size - i, '"') + 1;
   }
   return false;
 }
 
 bool HTTP::hasDisallowedUriToken(char c) {
-  return HTTP::specialUriTokens.find(c) == std::string::npos;
+  return !Scan::is(c, Scan::Classes::UriToken);
 }
 
 bool HTTP::hasDisallowedUriToken(const std::string& str) {
-  return str.find_first_not_of(HTTP::specialUriTokens) != std::string::npos;
+  return HTTP::hasDisallowedUriToken(str.data(), str.size());
+}
+
+bool HTTP::hasDisallowedUriToken(const char* str, size_t size) {
+  return Scan::findNonUriToken(str, size) != size;
 }
 
 std::string& HTTP::capitalizeHeader(std::string& str) {
@@ -15,7 +15,7 @@ int main(int ac, char** av, char** env) {
   YAML::RunTests();
   HTTP::ServerManager* serverManager = Instance::Get<HTTP::ServerManager>();
   try {
-    if (!serverManager->loadConfig(ac > 0 ? av[0] : settings->get<std::string>("misc.default_config_file")))
+    if (!serverManager->loadConfig(ac > 0 ? av[0] : settings->getSnapshot().defaultConfigFile))
       return 1;
   }
   catch (const std::exception& e) {
@@ -23,6 +23,15 @@ int main(int ac, char** av, char** env) {
     return 1;
   }
   serverManager->setEnv(env);
+  try {
+    serverManager->spawnWorkers();
+  }
+  catch (const std::exception& e) {
+    Utils::showException("Failed to spawn workers", e);
+    return 1;
+  }
+  if (serverManager->isSupervisor())
+    return serverManager->waitWorkers();
   try {
     serverManager->bindServers();
   }
@@ -30,6 +39,7 @@ int main(int ac, char** av, char** env) {
     Utils::showException("Failed to bind servers blocks", e);
     return 1;
   }
+  serverManager->startFastCGIPools();
   try {
     serverManager->run();
   }
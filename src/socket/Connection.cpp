@@ -10,6 +10,8 @@ Connection::Connection(
 )
   : handle(handle), serverSock(sock),
   timeout(timeout), heartbeat(Utils::getCurrentTime()),
+  timer(Timer::Targets::Client, this),
+  requests(0), maxRequests(0),
   closeOnEmptyWriteBuffer(false) {
   this->init();
 }
@@ -17,6 +19,8 @@ Connection::Connection(
 Connection::Connection(const Connection& other)
   : handle(other.handle), serverSock(other.serverSock),
   timeout(other.timeout), heartbeat(other.heartbeat),
+  timer(Timer::Targets::Client, this),
+  requests(other.requests), maxRequests(other.maxRequests),
   closeOnEmptyWriteBuffer(false) {
   this->init();
 }
@@ -55,18 +59,28 @@ ByteStream& Connection::getReadBuffer() {
   return this->readBuffer;
 }
 
-ByteStream& Connection::getWriteBuffer() {
-  return this->writeBuffer;
+Socket::WriteQueue& Connection::getWriteQueue() {
+  return this->writeQueue;
 }
 
 int Connection::getTimeout() const {
   return this->timeout;
 }
 
+void Connection::setTimeout(int timeout) {
+  if (this->timeout == timeout) return;
+  this->timeout = timeout;
+  this->timer.reschedule(this->heartbeat + this->timeout);
+}
+
 uint64_t Connection::getHeartbeat() const {
   return this->heartbeat;
 }
 
+Socket::Timer& Connection::getTimer() {
+  return this->timer;
+}
+
 bool Connection::isAlive() const {
   return !this->handle.isClosed() && !this->handle.isErrored();
 }
@@ -85,6 +99,7 @@ bool Connection::hasTimedOut() const {
 
 void Connection::ping() {
   this->heartbeat = Utils::getCurrentTime();
+  this->timer.reschedule(this->heartbeat + this->timeout);
 }
 
 void Connection::disconnect() {
@@ -7,17 +7,28 @@
 using Socket::Parallel;
 using Socket::Connection;
 using Socket::Process;
+using Socket::Timer;
+using Socket::WriteQueue;
 
 static Settings* settings = Instance::Get<Settings>();
 
+// timer wheel granularity (ms) & slot count, one revolution covers ~100s
+static const uint64_t timerResolution = 100;
+static const size_t timerSlots = 1024;
+// delay before retrying a disconnect that was refused (ms)
+static const uint64_t disconnectRetryDelay = 1000;
+// delay before polling the listeners again after running out of file descriptors (ms)
+static const uint64_t acceptRetryDelay = 100;
+static const int listenerEvents = EPOLLIN | EPOLLERR;
+
 Parallel::Parallel(int timeout)
-  : fileManager(this, &Parallel::onTick), timeout(timeout) {
-  try {
-    this->fileManager.setTimeout(settings->get<int>("socket.poll_timeout"));
-  }
-  catch (const std::exception& e) {
+  : fileManager(this, &Parallel::onTick), timers(timerResolution, timerSlots),
+  timeout(timeout), reusePort(false), acceptTimer(Timer::Targets::Listener, this), acceptPaused(false) {
+  this->fileManager.setBatchSize(settings->getSnapshot().epollBatch);
+  if (settings->getSnapshot().hasPollTimeout)
+    this->fileManager.setTimeout(settings->getSnapshot().pollTimeout);
+  else
     this->fileManager.setTimeout(Utils::getOrderOfMagnitude(timeout) / 4);
-  }
 }
 
 Parallel::~Parallel() {
@@ -41,7 +52,7 @@ const Socket::Server& Parallel::bind(
     throw std::runtime_error("Server already bound to address: " + static_cast<std::string>(host));
   if (!host.resolves())
     throw std::runtime_error("Failed to resolve host: " + static_cast<std::string>(host));
-  int sock = socket(domain, type, protocol);
+  int sock = socket(domain, type | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
   if (sock < 0)
     throw std::runtime_error("Failed to create socket");
   sockaddr_in serverAddress;
@@ -55,16 +66,20 @@ const Socket::Server& Parallel::bind(
   int reuse = 1;
   if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0)
     throw std::runtime_error("Failed to set socket to reusable");
+  // let every worker bind the same address, the kernel balances accepts between them
+  if (this->reusePort && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0)
+    throw std::runtime_error("Failed to set socket port to reusable");
   if (::bind(sock, (sockaddr*)&serverAddress, sizeof(serverAddress)) < 0)
     throw std::runtime_error("Failed to bind socket " + Utils::toString(sock) + " to host " + static_cast<std::string>(host));
   if (listen(sock, backlog) < 0)
     throw std::runtime_error("Failed to listen on socket");
-  if (!this->fileManager.add(sock, EPOLLIN | EPOLLET | EPOLLERR))
+  // level-triggered, connections left in the backlog after the accept budget wake us up again
+  if (!this->fileManager.add(sock, this->acceptPaused ? 0 : listenerEvents, File::Tags::Listener))
     throw std::runtime_error("Failed to add socket to file manager");
   Server server(sock, host.address, host.port, backlog);
-  ;
   this->addressesToSock.insert(std::make_pair<std::string, int>(host, sock));
-  const Server& ref = this->servers.insert(std::make_pair(sock, server)).first->second;
+  Server& ref = this->servers.insert(std::make_pair(sock, server)).first->second;
+  this->fileManager.get(sock).setOwner(&ref);
   return ref;
 }
 
@@ -164,7 +179,7 @@ bool Parallel::kill(int sock) {
 bool Parallel::disconnect(Connection& client) {
   if (!this->hasClient(client))
     return false;
-  if (client.isAlive() && client.getWriteBuffer().size() > 0)
+  if (client.isAlive() && !client.getWriteQueue().empty())
     return false;
   if (!this->onClientDisconnect(client))
     return false;
@@ -180,6 +195,8 @@ bool Parallel::disconnect(Connection& client) {
   this->addressesToSock.erase(address);
   this->clients.erase(con);
   this->fileManager.remove(con.getHandle(), true);
+  // a file descriptor was freed
+  this->resumeAccepting();
   return true;
 }
 
@@ -191,135 +208,168 @@ bool Parallel::disconnect(int client) {
 
 void Parallel::run() {
   this->fileManager.start();
+  const FileManager<Parallel>::Stats& stats = this->fileManager.getStats();
+  Logger::info
+    << "Event loop stopped after " << Logger::param(stats.batches) << " epoll batches, "
+    << Logger::param(stats.fullBatches) << " of them full (batch size "
+    << Logger::param(this->fileManager.getBatchSize()) << ")" << std::newl;
 }
 
-void Parallel::onTick(const std::vector<File>& changed) {
+void Parallel::onTick(const std::vector<File*>& changed) {
+  // responses of this tick share the same Date
+  Utils::refreshHTTPDate();
   for (
-    std::vector<File>::const_iterator it = changed.begin();
+    std::vector<File*>::const_iterator it = changed.begin();
     it != changed.end();
     ++it
     ) {
-    const File& file = *it;
+    const File& file = **it;
+    // a previous event in this batch may have released it
+    if (!file.isTracked())
+      continue;
     // Logger::debug
     //   << "fd: " << file << " | "
-    //   << "is client: " << this->hasClient(file) << " | "
-    //   << "is server: " << this->hasServer(file) << " | "
-    //   << "is process: " << this->hasProcessBoundTo(file) << " | "
+    //   << "tag: " << file.getTag() << " | "
     //   << "readable: " << std::boolalpha << file.isReadable() << " | "
     //   << "writable: " << std::boolalpha << file.isWritable() << " | "
     //   << "closed: " << std::boolalpha << file.isClosed() << " | "
     //   << "errored: " << std::boolalpha << file.isErrored() << ";" << std::newl;
-    if (this->hasServer(file))
-      this->_onNewConnection(this->getServer(file));
-    else if (this->hasClient(file)) {
-      const Connection& client = this->getClient(file);
-      if (!client.isAlive()) {
+    switch (file.getTag()) {
+      case File::Tags::Listener:
+        this->_onNewConnection(file.getOwner<Server>());
+        break;
+      case File::Tags::Client: {
+        Connection& client = file.getOwner<Connection>();
+        if (!client.isAlive()) {
+          // Logger::debug
+          //   << "client: " << client << " | "
+          //   << "isAlive: " << std::boolalpha << client.isAlive() << " | "
+          //   << "hasTimedOut: " << std::boolalpha << client.hasTimedOut() << std::newl;
+          if (this->_onClientDisconnect(client))
+            continue;
+        }
+        if (client.isReadable())
+          this->_onClientRead(client);
+        if (file.isTracked() && client.isWritable())
+          this->_onClientWrite(client);
+        break;
+      }
+      case File::Tags::Pipe: {
+        Process& process = file.getOwner<Process>();
         // Logger::debug
-        //   << "client: " << client << " | "
-        //   << "isAlive: " << std::boolalpha << client.isAlive() << " | "
-        //   << "hasTimedOut: " << std::boolalpha << client.hasTimedOut() << std::newl;
-        if (this->_onClientDisconnect(client))
+        //   << "pId: " << process.getId() << " | isAlive: " << std::boolalpha << process.isAlive() << std::newl
+        //   << " - is fd stdin: " << std::boolalpha << (process.hasIn() && file == process.getIn()) << " | "
+        //   << " - is fd stdout: " << std::boolalpha << (process.hasOut() && file == process.getOut()) << " | "
+        //   << std::newl;
+        if (file.isErrored() || (file == process.getIn() && !file.isReadable() && file.isClosed())) {
+          // Logger::debug
+          //   << "process: " << process.getId() << " | "
+          //   << "isAlive: " << std::boolalpha << process.isAlive() << " | "
+          //   << "isReadable: " << std::boolalpha << process.isReadable() << " | "
+          //   << "hasTimedOut: " << std::boolalpha << process.hasTimedOut() << std::newl;
+          if (file.isErrored())
+            this->_onProcessExit(process, Process::ExitCodes::Force);
+          else if (process.hasTimedOut())
+            this->_onProcessExit(process, Process::ExitCodes::Timeout);
+          else
+            this->_onProcessExit(process, Process::ExitCodes::Normal);
           continue;
+        }
+        if (file.isReadable())
+          this->_onProcessRead(process);
+        else if (file.isWritable())
+          this->_onProcessWrite(process);
+        break;
       }
-
-      const int clientSock = client.getHandle();
-      if (client.isReadable())
-        this->_onClientRead(const_cast<Connection&>(client));
-      if (this->hasClient(clientSock) && client.isWritable())
-        this->_onClientWrite(const_cast<Connection&>(client));
+      case File::Tags::Upstream:
+        this->onUpstreamEvent(file);
+        break;
+      default:
+        break;
     }
-    else if (this->hasProcessBoundTo(file)) {
-      Process& process = this->getProcessBoundTo(file);
-      // Logger::debug
-      //   << "pId: " << process.getId() << " | isAlive: " << std::boolalpha << process.isAlive() << std::newl
-      //   << " - is fd stdin: " << std::boolalpha << (process.hasIn() && file == process.getIn()) << " | "
-      //   << " - is fd stdout: " << std::boolalpha << (process.hasOut() && file == process.getOut()) << " | "
-      //   << std::newl;
-      if (file.isErrored() || (file == process.getIn() && !file.isReadable() && file.isClosed())) {
+  }
+  this->onTimersExpired();
+}
+
+void Parallel::onTimersExpired() {
+  this->timers.advance(Utils::getCurrentTime());
+  for (Timer* timer = this->timers.next(); timer; timer = this->timers.next()) {
+    switch (timer->getTarget()) {
+      case Timer::Targets::Client: {
+        Connection& client = timer->getOwner<Connection>();
         // Logger::debug
-        //   << "process: " << process.getId() << " | "
-        //   << "isAlive: " << std::boolalpha << process.isAlive() << " | "
-        //   << "isReadable: " << std::boolalpha << process.isReadable() << " | "
-        //   << "hasTimedOut: " << std::boolalpha << process.hasTimedOut() << std::newl;
-        if (file.isErrored())
-          this->_onProcessExit(process, Process::ExitCodes::Force);
-        else if (process.hasTimedOut())
-          this->_onProcessExit(process, Process::ExitCodes::Timeout);
-        else
-          this->_onProcessExit(process, Process::ExitCodes::Normal);
-        continue;
+        //   << "client: " << client << " | "
+        //   << "isAlive: " << std::boolalpha << client.isAlive() << " | "
+        //   << "hasTimedOut: " << std::boolalpha << client.hasTimedOut() << std::newl;
+        // still flushing or answering, try again shortly
+        if (!this->_onClientDisconnect(client))
+          timer->reschedule(Utils::getCurrentTime() + disconnectRetryDelay);
+        break;
       }
-      if (file.isReadable())
-        this->_onProcessRead(process);
-      else if (file.isWritable())
-        this->_onProcessWrite(process);
-    }
-  }
-  /* for (
-    std::set<File>::iterator it = this->fileManager.getAll().begin();
-    it != this->fileManager.getAll().end();
-    it++
-    ) {
-    const File& file = *it;
-    Logger::debug
-      << "fd: " << file << " | "
-      << "is client: " << this->hasClient(file) << " | "
-      << "is server: " << this->hasServer(file) << " | "
-      << "is process: " << this->hasProcessBoundTo(file) << " | "
-      << "readable: " << std::boolalpha << file.isReadable() << " | "
-      << "writable: " << std::boolalpha << file.isWritable() << " | "
-      << "closed: " << std::boolalpha << file.isClosed() << " | "
-      << "errored: " << std::boolalpha << file.isErrored() << ";" << std::newl;
-  } */
-  for (
-    std::map<int, Connection>::iterator it = this->clients.begin();
-    it != this->clients.end();
-    it++
-    ) {
-    const Connection& client = it->second;
-    if (std::find(changed.begin(), changed.end(), client.getHandle()) != changed.end())
-      continue;
-    if (!client.isAlive() || client.hasTimedOut()) {
-      // Logger::debug
-      //   << "client: " << client << " | "
-      //   << "isAlive: " << std::boolalpha << client.isAlive() << " | "
-      //   << "hasTimedOut: " << std::boolalpha << client.hasTimedOut() << std::newl;
-      this->_onClientDisconnect(client);
-    }
-  }
-  for (
-    std::map<pid_t, Process>::iterator it = this->processes.begin();
-    it != this->processes.end();
-    it++
-    ) {
-    Process& process = it->second;
-    if (process.hasTimedOut() || (!process.isAlive() && !process.isReadable())) {
-      Logger::debug
-        << "process: " << process.getId() << " | "
-        << "isAlive: " << std::boolalpha << process.isAlive() << " | "
-        << "isReadable: " << std::boolalpha << process.isReadable() << " | "
-        << "hasTimedOut: " << std::boolalpha << process.hasTimedOut() << std::newl;
-      this->_onProcessExit(process, process.hasTimedOut() ? Process::ExitCodes::Timeout : Process::ExitCodes::Normal);
+      case Timer::Targets::Process: {
+        Process& process = timer->getOwner<Process>();
+        Logger::debug
+          << "process: " << process.getId() << " | "
+          << "isAlive: " << std::boolalpha << process.isAlive() << " | "
+          << "hasTimedOut: " << std::boolalpha << process.hasTimedOut() << std::newl;
+        this->_onProcessExit(process, Process::ExitCodes::Timeout);
+        break;
+      }
+      case Timer::Targets::Listener:
+        this->resumeAccepting();
+        break;
+      case Timer::Targets::Upstream:
+        this->onUpstreamTimeout(*timer);
+        break;
+      default:
+        break;
     }
   }
 }
 
 void Parallel::_onNewConnection(Server& server) {
-  struct sockaddr_in clientAddress;
-  socklen_t clientAddressLength = sizeof(clientAddress);
+  const int budget = settings->getSnapshot().acceptBudget;
   Logger::debug
-    << "Accepting new con on host "
+    << "Accepting new cons on host "
     << Logger::param(static_cast<std::string>(server))
     << " with sock " << Logger::param(server.sock) << "..."
     << std::newl;
-  int clientSock = accept(server.sock, (sockaddr*)&clientAddress, &clientAddressLength);
+  // drain the backlog, but leave room for the other files in this tick
+  for (int i = 0; i < budget; i++) {
+    if (!this->_acceptConnection(server))
+      break;
+  }
+}
+
+bool Parallel::_acceptConnection(Server& server) {
+  struct sockaddr_in clientAddress;
+  socklen_t clientAddressLength = sizeof(clientAddress);
+  int clientSock = SYS_ACCEPT4(
+    server.sock, (sockaddr*)&clientAddress, &clientAddressLength,
+    SOCK_NONBLOCK | SOCK_CLOEXEC
+  );
   if (clientSock < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return false;
+    // peer gave up before we got to it, keep draining
+    if (errno == ECONNABORTED || errno == EINTR)
+      return true;
+    // the connection stays in the backlog, polling the level-triggered listeners would spin on it
+    if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+      Logger::error
+        << "Failed to accept new con on host "
+        << Logger::param(static_cast<std::string>(server))
+        << " with sock " << Logger::param(server.sock) << ": " << Logger::errstr()
+        << ", pausing accepts" << std::newl;
+      this->pauseAccepting();
+      return false;
+    }
     Logger::error
       << "Failed to accept new con on host "
       << Logger::param(static_cast<std::string>(server))
       << " with sock " << Logger::param(server.sock) << ": " << Logger::errstr()
       << std::newl;
-    return;
+    return false;
   }
   if (server.connections >= server.maxConnections) {
     Logger::warning
@@ -328,23 +378,45 @@ void Parallel::_onNewConnection(Server& server) {
       << " with sock " << Logger::param(server.sock) << ", closing peer.."
       << std::newl;
     SYS_CLOSE(clientSock);
-    return;
+    return true;
   }
-  if (!this->fileManager.add(clientSock, EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+  if (!this->fileManager.add(clientSock, EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR, File::Tags::Client))
     throw std::runtime_error("Failed to add socket to file manager");
-  const File& fileHandle = this->fileManager.get(clientSock);
-  Connection client(const_cast<File&>(fileHandle), server.sock, this->timeout);
+  File& fileHandle = this->fileManager.get(clientSock);
+  Connection client(fileHandle, server.sock, this->timeout);
   const std::string address(client);
   server.newConnection();
   this->addressesToSock.insert(std::make_pair(address, clientSock));
-  this->clients.insert(std::make_pair(fileHandle, client));
+  Connection& ref = this->clients.insert(std::make_pair(clientSock, client)).first->second;
+  fileHandle.setOwner(&ref);
+  this->timers.schedule(ref.getTimer(), ref.getHeartbeat() + ref.getTimeout());
   Logger::info
     << "Accepted new con from "
     << Logger::param(address)
     << " with sock " << Logger::param(fileHandle)
     << " on sock " << Logger::param(server.sock)
     << std::newl;
-  this->onClientConnect(this->getClient(clientSock));
+  this->onClientConnect(ref);
+  return true;
+}
+
+void Parallel::pauseAccepting() {
+  if (this->acceptPaused)
+    return;
+  this->acceptPaused = true;
+  for (std::map<int, Server>::iterator it = this->servers.begin(); it != this->servers.end(); ++it)
+    this->fileManager.update(it->first, 0);
+  this->timers.schedule(this->acceptTimer, Utils::getCurrentTime() + acceptRetryDelay);
+}
+
+void Parallel::resumeAccepting() {
+  if (!this->acceptPaused)
+    return;
+  this->acceptPaused = false;
+  this->acceptTimer.cancel();
+  for (std::map<int, Server>::iterator it = this->servers.begin(); it != this->servers.end(); ++it)
+    this->fileManager.update(it->first, listenerEvents);
+  Logger::debug << "Resumed accepting new cons" << std::newl;
 }
 
 bool Parallel::_onClientDisconnect(const Connection& client) {
@@ -352,13 +424,18 @@ bool Parallel::_onClientDisconnect(const Connection& client) {
 }
 
 void Parallel::_onClientRead(Connection& client) {
-  static const uint64_t bufferSize = settings->get<uint64_t>("socket.read_buffer_size");
+  const uint64_t bufferSize = settings->getSnapshot().readBufferSize;
   ByteStream& readBuffer = client.getReadBuffer();
   const uint64_t lastSize = readBuffer.size();
   readBuffer.resize(readBuffer.size() + bufferSize);
   void* buffer = readBuffer.data() + lastSize;
-  uint64_t read = recv(client.getHandle(), buffer, bufferSize, 0);
+  ssize_t read = recv(client.getHandle(), buffer, bufferSize, 0);
+  if (read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    readBuffer.resize(lastSize);
+    return;
+  }
   if (read <= 0) {
+    readBuffer.resize(lastSize);
     this->disconnect(client);
     return;
   }
@@ -371,39 +448,46 @@ void Parallel::_onClientRead(Connection& client) {
     else
       ss << (char)readBuffer[i];
   } */
-  Logger::debug
-    << "got " << Logger::param(read) << " bytes from "
-    << Logger::param(static_cast<std::string>(client))
-    << std::newl
-    << "---" << std::newl
-    << Logger::param(readBuffer.toString()) << std::newl
-    << "---" << std::newl;
+  if (Logger::debug.isEnabled())
+    Logger::debug
+      << "got " << Logger::param(read) << " bytes from "
+      << Logger::param(static_cast<std::string>(client))
+      << std::newl;
   client.ping();
   this->onClientRead(client);
 }
 
 void Parallel::_onClientWrite(Connection& client) {
-  static const uint64_t bufferSize = settings->get<uint64_t>("socket.write_buffer_size");
+  const uint64_t bufferSize = settings->getSnapshot().writeBufferSize;
   if (this->_onClientEmptyBuffer(client))
     return;
-  ByteStream& buffer = client.getWriteBuffer();
+  WriteQueue& queue = client.getWriteQueue();
 
-  uint64_t bytesToWrite = std::min(buffer.size(), bufferSize);
-  int wrote = send(client.getHandle(), buffer, bytesToWrite, 0);
+  // pull more from producers (e.g. streamed files) only once the queue runs low
+  queue.refill(bufferSize);
+  // gathers the pending segments into a single writev
+  ssize_t wrote = queue.flush(client.getHandle(), bufferSize);
+  if (wrote < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+    Logger::warning
+      << "Failed to write to " << Logger::param(static_cast<std::string>(client))
+      << ": " << Logger::errstr() << ", dropping it.." << std::newl;
+    queue.clear();
+    this->disconnect(client);
+    return;
+  }
   if (wrote <= 0) return;
-  Logger::debug
-    << "wrote " << Logger::param(wrote) << " bytes to "
-    << Logger::param(static_cast<std::string>(client)) << "."
-    << " " << Logger::param(buffer.size() - wrote) << " bytes left to write."
-    << std::newl;
+  if (Logger::debug.isEnabled())
+    Logger::debug
+      << "wrote " << Logger::param(wrote) << " bytes to "
+      << Logger::param(static_cast<std::string>(client)) << "."
+      << " " << Logger::param(queue.size()) << " bytes left to write."
+      << std::newl;
   this->onClientWrite(client, wrote);
-  buffer.ignore(wrote);
   client.ping();
 }
 
 bool Parallel::_onClientEmptyBuffer(Connection& client) {
-  ByteStream& buffer = client.getWriteBuffer();
-  if (buffer.size() > 0) return false;
+  if (!client.getWriteQueue().empty()) return false;
   if (client.shouldCloseOnEmptyWriteBuffer())
     this->disconnect(client);
   else
@@ -457,17 +541,25 @@ Process& Parallel::getProcessBoundTo(const int pipeFd) {
 bool Parallel::trackProcess(const pid_t pid, const Connection& con, int std[2]) {
   if (this->hasProcess(pid))
     return false;
-  if (!this->fileManager.add(std[0], EPOLLIN | EPOLLHUP | EPOLLERR))
+  if (!this->fileManager.add(std[0], EPOLLIN | EPOLLHUP | EPOLLERR, File::Tags::Pipe))
     return false;
-  if (!this->fileManager.add(std[1], EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+  // no stdin pipe when the process reads its input from elsewhere
+  if (std[1] >= 0 && !this->fileManager.add(std[1], EPOLLOUT | EPOLLHUP | EPOLLERR, File::Tags::Pipe)) {
     this->fileManager.remove(std[0], false);
     return false;
   }
   File& in = this->fileManager.get(std[0]);
-  File& out = this->fileManager.get(std[1]);
+  File* out = std[1] >= 0 ? &this->fileManager.get(std[1]) : NULL;
   this->pipesToProcesses.insert(std::make_pair(in, pid));
-  this->pipesToProcesses.insert(std::make_pair(out, pid));
-  this->processes.insert(std::make_pair(pid, Process(in, out, con, pid, settings->get<int>("http.cgi.timeout"))));
+  if (out)
+    this->pipesToProcesses.insert(std::make_pair(*out, pid));
+  Process& process = this->processes.insert(
+    std::make_pair(pid, Process(in, out, con, pid, settings->getSnapshot().cgiTimeout))
+  ).first->second;
+  in.setOwner(&process);
+  if (out)
+    out->setOwner(&process);
+  this->timers.schedule(process.getTimer(), process.getHeartbeat() + process.getTimeout());
   Logger::debug
     << "Tracking process " << Logger::param(pid)
     << " with pipes " << Logger::param(std[0]) << " and " << Logger::param(std[1])
@@ -475,8 +567,28 @@ bool Parallel::trackProcess(const pid_t pid, const Connection& con, int std[2])
   return true;
 }
 
+bool Parallel::trackUpstream(int fd, int flags, void* owner) {
+  if (!this->fileManager.add(fd, flags, File::Tags::Upstream))
+    return false;
+  this->fileManager.get(fd).setOwner(owner);
+  return true;
+}
+
+bool Parallel::updateUpstream(int fd, int flags) {
+  return this->fileManager.update(fd, flags);
+}
+
+void Parallel::untrackUpstream(int fd) {
+  if (!this->fileManager.remove(fd, true))
+    SYS_CLOSE(fd);
+}
+
+void Parallel::schedule(Timer& timer, uint64_t expiresAt) {
+  this->timers.schedule(timer, expiresAt);
+}
+
 void Parallel::_onProcessRead(Process& process) {
-  static const uint64_t bufferSize = settings->get<uint64_t>("socket.read_buffer_size");
+  const uint64_t bufferSize = settings->getSnapshot().readBufferSize;
   ByteStream& readBuffer = process.getReadBuffer();
   const uint64_t lastSize = readBuffer.size();
   readBuffer.resize(readBuffer.size() + bufferSize);
@@ -501,7 +613,7 @@ void Parallel::_onProcessRead(Process& process) {
 }
 
 void Parallel::_onProcessWrite(Process& process) {
-  static const uint64_t bufferSize = settings->get<uint64_t>("socket.write_buffer_size");
+  const uint64_t bufferSize = settings->getSnapshot().writeBufferSize;
   if (this->_onProcessEmptyBuffer(process))
     return;
   ByteStream& buffer = process.getWriteBuffer();
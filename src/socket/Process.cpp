@@ -20,19 +20,20 @@ std::string Process::ExitCodes::ToString(Code code) {
 
 Process::Process(
   File& in,
-  File& out,
+  File* out,
   const Connection& client,
   pid_t id,
   int timeout
 )
   : in(&in),
-  out(&out),
+  out(out),
   client(client),
   id(id),
   timeout(timeout),
-  heartbeat(Utils::getCurrentTime()) {
+  heartbeat(Utils::getCurrentTime()),
+  timer(Timer::Targets::Process, this) {
   this->std[0] = in.getFd();
-  this->std[1] = out.getFd();
+  this->std[1] = out ? out->getFd() : -1;
 }
 
 Process::Process(const Process& other)
@@ -42,7 +43,8 @@ Process::Process(const Process& other)
   client(other.client),
   id(other.id),
   timeout(other.timeout),
-  heartbeat(other.heartbeat) {
+  heartbeat(other.heartbeat),
+  timer(Timer::Targets::Process, this) {
   this->std[0] = other.std[0];
   this->std[1] = other.std[1];
 }
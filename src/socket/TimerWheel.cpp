@@ -0,0 +1,104 @@
+#include "socket/TimerWheel.hpp"
+#include <utils/misc.hpp>
+#include <algorithm>
+
+using Socket::Timer;
+using Socket::TimerWheel;
+
+Timer::Timer(Targets::Target target, void* owner)
+  : target(target), owner(owner), wheel(NULL),
+  prev(NULL), next(NULL), slot(Timer::npos), expiresAt(0) {}
+
+Timer::~Timer() {
+  this->cancel();
+}
+
+void Timer::reschedule(uint64_t expiresAt) {
+  if (!this->wheel) return;
+  this->wheel->schedule(*this, expiresAt);
+}
+
+void Timer::cancel() {
+  if (this->isScheduled())
+    this->wheel->cancel(*this);
+}
+
+TimerWheel::TimerWheel(uint64_t resolution, size_t slots)
+  : resolution(std::max<uint64_t>(resolution, 1)),
+  slots(std::max<size_t>(slots, 1) + 1, static_cast<Timer*>(NULL)),
+  current(Utils::getCurrentTime() / this->resolution) {}
+
+TimerWheel::~TimerWheel() {
+  for (size_t i = 0; i < this->slots.size(); i++) {
+    Timer* timer = this->slots[i];
+    while (timer) {
+      Timer* next = timer->next;
+      timer->prev = timer->next = NULL;
+      timer->slot = Timer::npos;
+      timer->wheel = NULL;
+      timer = next;
+    }
+    this->slots[i] = NULL;
+  }
+}
+
+void TimerWheel::schedule(Timer& timer, uint64_t expiresAt) {
+  if (timer.isScheduled())
+    this->unlink(timer);
+  timer.wheel = this;
+  timer.expiresAt = expiresAt;
+  const uint64_t tick = std::max(expiresAt / this->resolution, this->current);
+  this->link(timer, tick % this->pendingSlot());
+}
+
+void TimerWheel::cancel(Timer& timer) {
+  if (timer.wheel != this || !timer.isScheduled()) return;
+  this->unlink(timer);
+}
+
+void TimerWheel::advance(uint64_t now) {
+  const uint64_t target = now / this->resolution;
+  if (target <= this->current) return;
+  // a full revolution already visits every slot
+  const uint64_t ticks = std::min<uint64_t>(target - this->current, this->pendingSlot());
+  for (uint64_t i = 0; i < ticks; i++) {
+    Timer* timer = this->slots[(this->current + i) % this->pendingSlot()];
+    while (timer) {
+      Timer* next = timer->next;
+      if (timer->expiresAt <= now) {
+        this->unlink(*timer);
+        this->link(*timer, this->pendingSlot());
+      }
+      timer = next;
+    }
+  }
+  this->current = target;
+}
+
+Timer* TimerWheel::next() {
+  Timer* timer = this->slots[this->pendingSlot()];
+  if (timer)
+    this->unlink(*timer);
+  return timer;
+}
+
+void TimerWheel::link(Timer& timer, size_t slot) {
+  Timer*& head = this->slots[slot];
+  timer.prev = NULL;
+  timer.next = head;
+  if (head)
+    head->prev = &timer;
+  head = &timer;
+  timer.slot = slot;
+}
+
+void TimerWheel::unlink(Timer& timer) {
+  if (timer.prev)
+    timer.prev->next = timer.next;
+  else
+    this->slots[timer.slot] = timer.next;
+  if (timer.next)
+    timer.next->prev = timer.prev;
+  timer.prev = timer.next = NULL;
+  timer.slot = Timer::npos;
+}
@@ -0,0 +1,183 @@
+#include "socket/WriteQueue.hpp"
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+
+using Socket::WriteQueue;
+
+// max amount of segments handed to a single writev call
+static const size_t maxIovecs = 64;
+
+WriteQueue::WriteQueue() : segments(), bytes(0) {}
+
+WriteQueue::~WriteQueue() {
+  this->clear();
+}
+
+void WriteQueue::push(ByteStream& data) {
+  if (data.empty()) return;
+  ByteStream* owned = new ByteStream();
+  owned->swap(data);
+  this->segments.push_back(Segment(owned, owned->data(), owned->size()));
+  this->bytes += owned->size();
+}
+
+void WriteQueue::push(const std::string& data) {
+  if (data.empty()) return;
+  ByteStream stream;
+  stream.put(data);
+  this->push(stream);
+}
+
+void WriteQueue::borrow(const void* data, uint64_t size) {
+  if (size == 0) return;
+  this->segments.push_back(Segment(static_cast<ByteStream*>(NULL), static_cast<const uint8_t*>(data), size));
+  this->bytes += size;
+}
+
+void WriteQueue::share(SharedBuffer* buffer, uint64_t offset, uint64_t size) {
+  if (size == 0) return;
+  this->segments.push_back(Segment(buffer->retain(), buffer->get().data() + offset, size));
+  this->bytes += size;
+}
+
+WriteQueue::SharedBuffer::SharedBuffer() : data(), refs(1) {}
+
+WriteQueue::SharedBuffer::~SharedBuffer() {}
+
+void WriteQueue::SharedBuffer::release() {
+  if (--this->refs == 0)
+    delete this;
+}
+
+WriteQueue::SharedFd::SharedFd(int fd) : fd(fd), refs(1) {}
+
+WriteQueue::SharedFd::~SharedFd() {
+  if (this->fd >= 0)
+    ::close(this->fd);
+}
+
+void WriteQueue::SharedFd::release() {
+  if (--this->refs == 0)
+    delete this;
+}
+
+void WriteQueue::pushFile(int fd, uint64_t offset, uint64_t size) {
+  SharedFd* file = new SharedFd(fd);
+  this->pushFile(file, offset, size);
+  file->release();
+}
+
+void WriteQueue::pushFile(SharedFd* file, uint64_t offset, uint64_t size) {
+  if (size == 0) return;
+  this->segments.push_back(Segment(file->retain(), offset, size));
+  this->bytes += size;
+}
+
+void WriteQueue::pushProducer(Producer* producer) {
+  this->segments.push_back(Segment(producer));
+}
+
+void WriteQueue::refill(uint64_t watermark) {
+  uint64_t ready = 0;
+  size_t index = 0;
+  for (; index < this->segments.size() && !this->segments[index].isProducer(); index++)
+    ready += this->segments[index].remaining();
+  while (index < this->segments.size() && ready < watermark) {
+    WriteQueue produced;
+    const bool done = !this->segments[index].producer->produce(produced);
+    // splice what was produced in front of the producer
+    const size_t count = produced.segments.size();
+    this->segments.insert(
+      this->segments.begin() + index,
+      produced.segments.begin(), produced.segments.end()
+    );
+    this->bytes += produced.bytes;
+    ready += produced.bytes;
+    produced.segments.clear();
+    produced.bytes = 0;
+    index += count;
+    if (!done) continue;
+    delete this->segments[index].producer;
+    this->segments.erase(this->segments.begin() + index);
+    // move on to the next producer, if any
+    for (; index < this->segments.size() && !this->segments[index].isProducer(); index++)
+      ready += this->segments[index].remaining();
+  }
+}
+
+void WriteQueue::consume(uint64_t bytes) {
+  while (bytes > 0 && !this->segments.empty()) {
+    Segment& segment = this->segments.front();
+    if (segment.isProducer()) break;
+    const uint64_t amount = std::min(bytes, segment.remaining());
+    segment.offset += amount;
+    this->bytes -= amount;
+    bytes -= amount;
+    if (segment.remaining() == 0)
+      this->pop();
+  }
+}
+
+void WriteQueue::clear() {
+  while (!this->segments.empty())
+    this->pop();
+  this->bytes = 0;
+}
+
+ssize_t WriteQueue::flush(int fd, uint64_t maxBytes) {
+  if (this->segments.empty()) return 0;
+  if (this->segments.front().isFile())
+    return this->flushFile(fd, maxBytes);
+  struct iovec iov[maxIovecs];
+  size_t count = 0;
+  uint64_t total = 0;
+  if (this->segments.front().isProducer())
+    return 0;
+  // memory segments up to the next file or producer one
+  for (
+    std::deque<Segment>::const_iterator it = this->segments.begin();
+    it != this->segments.end() && !it->isFile() && !it->isProducer() && count < maxIovecs && total < maxBytes;
+    ++it
+    ) {
+    const uint64_t len = std::min(it->remaining(), maxBytes - total);
+    iov[count].iov_base = const_cast<uint8_t*>(it->data + it->offset);
+    iov[count].iov_len = len;
+    total += len;
+    count++;
+  }
+  if (count == 0) return 0;
+  const ssize_t wrote = ::writev(fd, iov, count);
+  if (wrote > 0)
+    this->consume(wrote);
+  return wrote;
+}
+
+ssize_t WriteQueue::flushFile(int fd, uint64_t maxBytes) {
+  const Segment& segment = this->segments.front();
+  off_t offset = segment.start + segment.offset;
+  const ssize_t wrote = ::sendfile(fd, segment.file->get(), &offset, std::min(segment.remaining(), maxBytes));
+  if (wrote > 0)
+    this->consume(wrote);
+  else if (wrote == 0) {
+    // the file shrank since it was queued, what was promised can't be sent anymore
+    this->clear();
+    errno = EIO;
+    return -1;
+  }
+  return wrote;
+}
+
+void WriteQueue::pop() {
+  Segment& segment = this->segments.front();
+  this->bytes -= segment.remaining();
+  delete segment.owned;
+  delete segment.producer;
+  if (segment.shared)
+    segment.shared->release();
+  if (segment.isFile())
+    segment.file->release();
+  this->segments.pop_front();
+}
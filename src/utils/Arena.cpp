@@ -0,0 +1,92 @@
+#include "utils/Arena.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <algorithm>
+
+using Utils::Arena;
+
+Arena::Arena(size_t blockSize)
+  : blockSize(blockSize), blocks(NULL), cursor(NULL), end(NULL), bytes(0), total(0) {}
+
+Arena::~Arena() {
+  this->release();
+}
+
+Arena::Arena(const Arena& other)
+  : blockSize(other.blockSize), blocks(NULL), cursor(NULL), end(NULL), bytes(0), total(0) {}
+
+Arena& Arena::operator=(const Arena& other) {
+  if (this == &other) return *this;
+  this->release();
+  this->blockSize = other.blockSize;
+  return *this;
+}
+
+void Arena::swap(Arena& other) {
+  std::swap(this->blockSize, other.blockSize);
+  std::swap(this->blocks, other.blocks);
+  std::swap(this->cursor, other.cursor);
+  std::swap(this->end, other.end);
+  std::swap(this->bytes, other.bytes);
+  std::swap(this->total, other.total);
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+  uintptr_t at = (reinterpret_cast<uintptr_t>(this->cursor) + align - 1) & ~(align - 1);
+  if (!this->cursor || at + size > reinterpret_cast<uintptr_t>(this->end)) {
+    this->grow(size, align);
+    at = (reinterpret_cast<uintptr_t>(this->cursor) + align - 1) & ~(align - 1);
+  }
+  this->bytes += at + size - reinterpret_cast<uintptr_t>(this->cursor);
+  this->cursor = reinterpret_cast<char*>(at + size);
+  return reinterpret_cast<void*>(at);
+}
+
+char* Arena::copy(const char* data, size_t size) {
+  char* str = static_cast<char*>(this->allocate(size + 1, 1));
+  if (size > 0)
+    std::memcpy(str, data, size);
+  str[size] = '\0';
+  return str;
+}
+
+void Arena::grow(size_t size, size_t align) {
+  // the block header keeps the data aligned for anything up to its own size
+  const size_t dataSize = std::max(this->blockSize, size + align);
+  Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + dataSize));
+  if (!block)
+    throw std::bad_alloc();
+  block->next = this->blocks;
+  block->size = dataSize;
+  this->blocks = block;
+  this->cursor = reinterpret_cast<char*>(block + 1);
+  this->end = this->cursor + dataSize;
+  this->total += dataSize;
+}
+
+void Arena::reset() {
+  this->bytes = 0;
+  if (!this->blocks)
+    return;
+  // a single block big enough for everything the last round needed
+  if (this->blocks->next) {
+    const size_t size = this->total;
+    this->release();
+    this->grow(size, 1);
+    return;
+  }
+  this->cursor = reinterpret_cast<char*>(this->blocks + 1);
+}
+
+void Arena::release() {
+  while (this->blocks) {
+    Block* next = this->blocks->next;
+    std::free(this->blocks);
+    this->blocks = next;
+  }
+  this->cursor = NULL;
+  this->end = NULL;
+  this->bytes = 0;
+  this->total = 0;
+}
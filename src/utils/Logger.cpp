@@ -4,7 +4,7 @@
 using namespace Logger;
 
 static const Settings* settings = Instance::Get<Settings>();
-static const int logLevel = settings->get<int>("misc.log_level");
+static const int logLevel = settings->getSnapshot().logLevel;
 
 Stream Logger::debug("DEBUG", CYAN, logLevel > -1 && logLevel <= 0);
 Stream Logger::info("INFO", BLUE, logLevel > -1 && logLevel <= 1);
@@ -2,6 +2,7 @@
 #include <utils/Logger.hpp>
 #include <execinfo.h>
 #include <unistd.h>
+#include <ctime>
 
 std::vector<std::string> Utils::split(const std::string& str, std::string delim)
 {
@@ -27,23 +28,43 @@ std::string& Utils::capitalize(std::string& str)
   return str;
 }
 
+static size_t formatDate(time_t rawtime, char* buffer, size_t size) {
+  struct tm timeinfo;
+  if (!gmtime_r(&rawtime, &timeinfo))
+    return 0;
+  return strftime(buffer, size, "%a, %d %b %Y %H:%M:%S GMT", &timeinfo);
+}
+
 // formats time in this format Fri, 21 Jul 2023 19:27:34 GMT
 std::string Utils::getJSONDate(time_t basetime /* = -1 */)
 {
-  std::string result;
-  time_t rawtime;
-  struct tm* timeinfo;
   char buffer[80];
+  time_t rawtime;
 
   if (basetime != -1)
     rawtime = basetime;
   else
     time(&rawtime);
-  timeinfo = gmtime(&rawtime);
+  return std::string(buffer, formatDate(rawtime, buffer, sizeof(buffer)));
+}
 
-  strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", timeinfo);
-  result = buffer;
-  return result;
+static time_t httpDateSecond = -1;
+static std::string httpDate;
+
+void Utils::refreshHTTPDate() {
+  const time_t now = time(NULL);
+  if (now == httpDateSecond)
+    return;
+  char buffer[80];
+  // same length every second, assign keeps reusing its buffer
+  httpDate.assign(buffer, formatDate(now, buffer, sizeof(buffer)));
+  httpDateSecond = now;
+}
+
+const std::string& Utils::getHTTPDate() {
+  if (httpDateSecond == -1)
+    Utils::refreshHTTPDate();
+  return httpDate;
 }
 
 void Utils::showStackTrace() {